@@ -29,9 +29,8 @@ private:
     }
 
     void onMessage(const muduo::TcpConnectionPtr& conn, muduo::Buffer* buf, muduo::TimeStamp time) {
-        std::string msg(buf->retrieveAllAsString());
-        LOG_INFO("connection [%s] recv %ld bytes at %s", conn->name().c_str(), msg.size(), time.toString().c_str());
-        conn->send(msg);
+        LOG_INFO("connection [%s] recv %ld bytes at %s", conn->name().c_str(), buf->readableBytes(), time.toString().c_str());
+        conn->send(buf);
     }
 
     TcpServer server_;
@@ -3,26 +3,50 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <endian.h>
+#include <sys/types.h>
+
+#include "StringPiece.h"
+#include "ByteScanner.h"
 
 namespace muduo {
 
 /**
  * @brief Buffer 类
  * @note readFd 从 对端读取数据到 buffer_ 中；通过 writeFd 将 buffer_ 中的数据写入到对端
+ * readFd 会根据最近几次读到的数据量自适应地预留可写空间，尽量让数据直接读进 buffer_，而不是先读到栈上再拷贝一次
+ *
+ * +-------------------+------------------+------------------+
+ * | prependable bytes |  readable bytes  |  writable bytes  |
+ * +-------------------+------------------+------------------+
+ * 0          <=  readerIndex   <=   writerIndex    <=     size
+ *
+ * 整数的 append/peek/read/prepend 均使用网络字节序（大端）
+ * 前部预留的 kCheapPrepend 字节可以用 prepend 在已经序列化好的消息体前面补写长度头，无需再拷贝一次消息体
  */
 class Buffer {
 public:
     static const size_t kCheapPrepend = 8;      // 前部预留空间
     static const size_t kInitialSize = 1024;    // 初始大小
+    static const size_t kMaxReadSizeHint = 128 * 1024;     // readFd 预留可写空间的上限
 
     explicit Buffer(size_t initialSize = kInitialSize)
         : buffer_(kCheapPrepend + initialSize),
           readerIndex_(kCheapPrepend),
-          writerIndex_(kCheapPrepend) {}
+          writerIndex_(kCheapPrepend),
+          readSizeHint_(std::max(initialSize, kInitialSize)),
+          smallReads_(0),
+          numReads_(0),
+          numOverflowReads_(0) {}
     
     size_t readableBytes() const { return writerIndex_ - readerIndex_; }
     size_t writableBytes() const { return buffer_.size() - writerIndex_; }
     size_t prependableBytes() const { return readerIndex_; }
+    size_t internalCapacity() const { return buffer_.capacity(); }
 
     const char* peek() const { return begin() + readerIndex_; }
 
@@ -35,11 +59,21 @@ public:
         }
     }
 
+    // 取出直到 end 为止的数据，end 通常来自 findCRLF 等查找函数
+    void retrieveUntil(const char* end) {
+        retrieve(end - peek());
+    }
+
     void retrieveAll() {
         readerIndex_ = kCheapPrepend;
         writerIndex_ = kCheapPrepend;
     }
 
+    void retrieveInt64() { retrieve(sizeof(int64_t)); }
+    void retrieveInt32() { retrieve(sizeof(int32_t)); }
+    void retrieveInt16() { retrieve(sizeof(int16_t)); }
+    void retrieveInt8() { retrieve(sizeof(int8_t)); }
+
     std::string retrieveAllAsString() {
         return retrieveAsString(readableBytes());
     }
@@ -50,6 +84,50 @@ public:
         return str;
     }
 
+    StringPiece toStringPiece() const {
+        return StringPiece(peek(), readableBytes());
+    }
+
+    /**
+     * 零拷贝取出数据：返回指向可读区域的视图并移动读指针，不分配也不拷贝
+     * 返回的视图在下一次向 Buffer 写入（append/readFd/shrink 等）之前有效
+     */
+    StringPiece retrieveAsPiece(size_t len) {
+        len = std::min(len, readableBytes());
+        StringPiece piece(peek(), len);
+        retrieve(len);
+        return piece;
+    }
+
+    StringPiece retrieveAllAsPiece() {
+        return retrieveAsPiece(readableBytes());
+    }
+
+    /**
+     * 在可读区域 [start, beginWrite()) 中查找分隔符，找不到时返回 nullptr
+     * 由 ByteScanner 在运行时选择 AVX2/SSE2/标量实现，供行协议（HTTP 头部、Redis、memcached 文本协议等）解析使用
+     */
+    const char* findCRLF() const { return findCRLF(peek()); }
+    const char* findCRLF(const char* start) const {
+        return ByteScanner::best().findCRLF(start, beginWrite());
+    }
+
+    const char* findEOL() const { return findEOL(peek()); }
+    const char* findEOL(const char* start) const {
+        return ByteScanner::best().findByte(start, beginWrite(), '\n');
+    }
+
+    const char* findByte(char c) const { return findByte(peek(), c); }
+    const char* findByte(const char* start, char c) const {
+        return ByteScanner::best().findByte(start, beginWrite(), c);
+    }
+
+    // 查找 set 中任意一个字节第一次出现的位置
+    const char* findAnyOf(const StringPiece& set) const { return findAnyOf(peek(), set); }
+    const char* findAnyOf(const char* start, const StringPiece& set) const {
+        return ByteScanner::best().findAnyOf(start, beginWrite(), set.data(), set.size());
+    }
+
     void ensureWritableBytes(size_t len) {
         if (writableBytes() < len) {
             makeSpace(len);
@@ -65,6 +143,159 @@ public:
         writerIndex_ += len;
     }
 
+    void append(const void* data, size_t len) {
+        append(static_cast<const char*>(data), len);
+    }
+
+    void append(const StringPiece& str) {
+        append(str.data(), str.size());
+    }
+
+    // 直接向 beginWrite() 写入数据之后调用，移动写指针
+    void hasWritten(size_t len) {
+        assert(len <= writableBytes());
+        writerIndex_ += len;
+    }
+
+    // 撤销最后写入的 len 字节
+    void unwrite(size_t len) {
+        assert(len <= readableBytes());
+        writerIndex_ -= len;
+    }
+
+    // 以网络字节序追加整数
+    void appendInt64(int64_t x) {
+        int64_t be64 = static_cast<int64_t>(htobe64(static_cast<uint64_t>(x)));
+        append(&be64, sizeof be64);
+    }
+
+    void appendInt32(int32_t x) {
+        int32_t be32 = static_cast<int32_t>(htobe32(static_cast<uint32_t>(x)));
+        append(&be32, sizeof be32);
+    }
+
+    void appendInt16(int16_t x) {
+        int16_t be16 = static_cast<int16_t>(htobe16(static_cast<uint16_t>(x)));
+        append(&be16, sizeof be16);
+    }
+
+    void appendInt8(int8_t x) {
+        append(&x, sizeof x);
+    }
+
+    // 读取网络字节序的整数并移动读指针，要求 readableBytes() >= sizeof(intN_t)
+    int64_t readInt64() {
+        int64_t result = peekInt64();
+        retrieveInt64();
+        return result;
+    }
+
+    int32_t readInt32() {
+        int32_t result = peekInt32();
+        retrieveInt32();
+        return result;
+    }
+
+    int16_t readInt16() {
+        int16_t result = peekInt16();
+        retrieveInt16();
+        return result;
+    }
+
+    int8_t readInt8() {
+        int8_t result = peekInt8();
+        retrieveInt8();
+        return result;
+    }
+
+    // 读取网络字节序的整数但不移动读指针，要求 readableBytes() >= sizeof(intN_t)
+    int64_t peekInt64() const {
+        assert(readableBytes() >= sizeof(int64_t));
+        uint64_t be64 = 0;
+        ::memcpy(&be64, peek(), sizeof be64);
+        return static_cast<int64_t>(be64toh(be64));
+    }
+
+    int32_t peekInt32() const {
+        assert(readableBytes() >= sizeof(int32_t));
+        uint32_t be32 = 0;
+        ::memcpy(&be32, peek(), sizeof be32);
+        return static_cast<int32_t>(be32toh(be32));
+    }
+
+    int16_t peekInt16() const {
+        assert(readableBytes() >= sizeof(int16_t));
+        uint16_t be16 = 0;
+        ::memcpy(&be16, peek(), sizeof be16);
+        return static_cast<int16_t>(be16toh(be16));
+    }
+
+    int8_t peekInt8() const {
+        assert(readableBytes() >= sizeof(int8_t));
+        return static_cast<int8_t>(*peek());
+    }
+
+    /**
+     * 在可读数据前面写入 len 字节，使用前部的预留空间，要求 len <= prependableBytes()
+     * 典型用法：先 append 消息体，再 prependInt32(readableBytes()) 补写长度头
+     */
+    void prepend(const void* data, size_t len) {
+        assert(len <= prependableBytes());
+        readerIndex_ -= len;
+        const char* d = static_cast<const char*>(data);
+        std::copy(d, d + len, begin() + readerIndex_);
+    }
+
+    void prependInt64(int64_t x) {
+        int64_t be64 = static_cast<int64_t>(htobe64(static_cast<uint64_t>(x)));
+        prepend(&be64, sizeof be64);
+    }
+
+    void prependInt32(int32_t x) {
+        int32_t be32 = static_cast<int32_t>(htobe32(static_cast<uint32_t>(x)));
+        prepend(&be32, sizeof be32);
+    }
+
+    void prependInt16(int16_t x) {
+        int16_t be16 = static_cast<int16_t>(htobe16(static_cast<uint16_t>(x)));
+        prepend(&be16, sizeof be16);
+    }
+
+    void prependInt8(int8_t x) {
+        prepend(&x, sizeof x);
+    }
+
+    void swap(Buffer& rhs) {
+        buffer_.swap(rhs.buffer_);
+        std::swap(readerIndex_, rhs.readerIndex_);
+        std::swap(writerIndex_, rhs.writerIndex_);
+        std::swap(readSizeHint_, rhs.readSizeHint_);
+        std::swap(smallReads_, rhs.smallReads_);
+        std::swap(numReads_, rhs.numReads_);
+        std::swap(numOverflowReads_, rhs.numOverflowReads_);
+    }
+
+    // 收缩缓冲区，只保留可读数据和 reserve 字节的可写空间，释放突发流量撑大的内存
+    void shrink(size_t reserve) {
+        Buffer other(readableBytes() + reserve);
+        other.append(peek(), readableBytes());
+        other.readSizeHint_ = readSizeHint_;
+        other.numReads_ = numReads_;
+        other.numOverflowReads_ = numOverflowReads_;
+        swap(other);
+    }
+
+    // readFd 下一次预留的可写空间大小
+    size_t readSizeHint() const { return readSizeHint_; }
+
+    // readFd 的调用次数，以及其中可写空间不够、数据溢出到栈上额外空间的次数
+    uint64_t numReads() const { return numReads_; }
+    uint64_t numOverflowReads() const { return numOverflowReads_; }
+
+    // 所有 Buffer 合计的溢出次数与溢出字节数
+    static uint64_t totalOverflowReads() { return s_totalOverflowReads_; }
+    static uint64_t totalOverflowBytes() { return s_totalOverflowBytes_; }
+
     ssize_t readFd(int fd, int *savedErrno);
     ssize_t writeFd(int fd, int *savedErrno);
     
@@ -85,9 +316,21 @@ private:
         }
     }
 
+    void adjustReadSizeHint(size_t n, size_t writable);
+
+    static const int kShrinkAfterSmallReads = 4;    // 连续这么多次读到的数据都很少时才缩小预留空间
+
     std::vector<char> buffer_;
     size_t readerIndex_;
     size_t writerIndex_;
+
+    size_t readSizeHint_;       // 下一次 readFd 预留的可写空间
+    int smallReads_;            // 连续读到少量数据的次数
+    uint64_t numReads_;
+    uint64_t numOverflowReads_;
+
+    static std::atomic<uint64_t> s_totalOverflowReads_;
+    static std::atomic<uint64_t> s_totalOverflowBytes_;
 };
 
 }
\ No newline at end of file
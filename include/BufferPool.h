@@ -0,0 +1,66 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+#include "nocopyable.h"
+
+namespace muduo {
+
+/**
+ * @brief 固定大小内存块池
+ * @note 每个 EventLoop 持有一个，供 ChainBuffer 申请/归还内存块，避免反复向全局分配器申请大块内存
+ * 内存块可能在非 IO 线程归还（如 TcpConnection 在其他线程析构），所以空闲链表用互斥锁保护
+ * 统计信息使用原子变量，可以在任意线程查询
+ */
+class BufferPool : nocopyable {
+public:
+    static const size_t kDefaultBlockSize = 16 * 1024;     // 默认内存块大小 16KB
+    static const size_t kDefaultMaxFreeBlocks = 256;       // 最多缓存的空闲内存块数
+
+    explicit BufferPool(size_t blockSize = kDefaultBlockSize, size_t maxFreeBlocks = kDefaultMaxFreeBlocks);
+    ~BufferPool();
+
+    char* allocate();               // 申请一个内存块，超过内存上限时返回 nullptr
+    void deallocate(char* block);   // 归还一个内存块
+
+    // 释放上次 trim 以来一直没有被用到的空闲内存块，由 EventLoop 周期性调用
+    void trim();
+
+    size_t blockSize() const { return blockSize_; }
+
+    // 本内存池的内存上限（已借出的字节数），0 表示不限制
+    void setMaxBytes(size_t maxBytes) { maxBytes_ = maxBytes; }
+    size_t maxBytes() const { return maxBytes_; }
+
+    size_t bytesInUse() const { return bytesInUse_; }           // 已借出的字节数
+    size_t peakBytesInUse() const { return peakBytesInUse_; }   // 已借出字节数的峰值
+    size_t bytesCached() const { return bytesCached_; }         // 缓存的空闲字节数
+    size_t numAllocFailures() const { return numAllocFailures_; }   // 因超过上限而拒绝分配的次数
+
+    // 所有内存池合计的内存上限，0 表示不限制
+    static void setGlobalMaxBytes(size_t maxBytes) { s_globalMaxBytes_ = maxBytes; }
+    static size_t globalMaxBytes() { return s_globalMaxBytes_; }
+    static size_t globalBytesInUse() { return s_globalBytesInUse_; }
+
+private:
+    const size_t blockSize_;
+    const size_t maxFreeBlocks_;
+    std::atomic<size_t> maxBytes_;
+
+    std::mutex mutex_;
+    std::vector<char*> freeBlocks_;     // 空闲内存块
+    size_t minFreeSinceTrim_;           // 上次 trim 以来空闲内存块数的最小值，这部分内存块一直没被用到
+
+    std::atomic<size_t> bytesInUse_;
+    std::atomic<size_t> peakBytesInUse_;
+    std::atomic<size_t> bytesCached_;
+    std::atomic<size_t> numAllocFailures_;
+
+    static std::atomic<size_t> s_globalMaxBytes_;
+    static std::atomic<size_t> s_globalBytesInUse_;
+};
+
+}
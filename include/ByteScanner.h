@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+namespace muduo {
+
+/**
+ * @brief 字节查找函数表，用于在缓冲区中查找分隔符（CRLF、单个字节、字节集合）
+ * @note 提供标量、SSE2、AVX2 三种实现，运行时根据 CPU 支持的指令集选择最优实现
+ * 单字节查找各级别都使用 libc 的 memchr（glibc 内部已按 CPU 选择了向量化实现）
+ * 所有函数在 [begin, end) 中查找，找不到时返回 nullptr
+ */
+struct ByteScanner {
+    enum Level {
+        kScalar,
+        kSSE2,
+        kAVX2,
+    };
+
+    const char* (*findByte)(const char* begin, const char* end, char c);
+    const char* (*findAnyOf)(const char* begin, const char* end, const char* set, size_t setLen);
+    const char* (*findCRLF)(const char* begin, const char* end);
+    Level level;
+    const char* name;
+
+    // 当前 CPU 上最优的实现，首次调用时选择
+    static const ByteScanner& best();
+
+    // 指定指令集的实现，CPU 不支持时返回 nullptr
+    static const ByteScanner* get(Level level);
+};
+
+}
@@ -5,6 +5,7 @@
 
 #include "Buffer.h"
 #include "TimeStamp.h"
+#include "InlineFunction.h"
 
 namespace muduo {
 
@@ -16,8 +17,15 @@ using ConnectionCallback = std::function<void(const TcpConnectionPtr&)>;
 using CloseCallback = std::function<void(const TcpConnectionPtr&)>;
 using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
 using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
+using LowWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
 using MessageCallback = std::function<void(const TcpConnectionPtr&, Buffer*, TimeStamp)>;
 
-using TimerCallback = std::function<void()>;
+// 空闲类型：一段时间内没有读到数据、没有写出数据、既没有读也没有写
+enum IdleType { kReaderIdle, kWriterIdle, kAllIdle, kNumIdleTypes };
+using IdleCallback = std::function<void(const TcpConnectionPtr&, IdleType)>;
+
+// 投递到 EventLoop 的任务：成员函数指针 + shared_ptr<TcpConnection> + 一个 std::string 或 Buffer 参数可以内联存放，不需要堆分配
+using Task = InlineFunction<void(), 104>;
+using TimerCallback = Task;
 
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "BufferPool.h"
+#include "nocopyable.h"
+
+namespace muduo {
+
+/**
+ * @brief 由固定大小内存块串成的链式缓冲区
+ * @note 接口与 Buffer 保持一致（peek/retrieve/append/readFd/writeFd），内存块来自 EventLoop 的 BufferPool
+ * 追加数据只会在尾部申请新的内存块，不会像 Buffer 那样 resize 或搬移已有数据，适合作为大数据量的发送缓冲区
+ * 由于数据不连续，peek() 只保证返回的指针之后有 contiguousBytes() 个可读字节
+ * 数据被取空时所有内存块都会归还给内存池，空闲连接不占用发送缓冲区内存
+ */
+class ChainBuffer : nocopyable {
+public:
+    explicit ChainBuffer(std::shared_ptr<BufferPool> pool = std::shared_ptr<BufferPool>());
+    ~ChainBuffer();
+
+    size_t readableBytes() const { return readableBytes_; }
+    size_t contiguousBytes() const { return blocks_.empty() ? 0 : blocks_.front().readableBytes(); }
+    size_t numBlocks() const { return blocks_.size(); }
+
+    const char* peek() const { return blocks_.empty() ? nullptr : blocks_.front().data + blocks_.front().readIndex; }
+
+    void retrieve(size_t len);
+    void retrieveAll();
+
+    std::string retrieveAllAsString() {
+        return retrieveAsString(readableBytes());
+    }
+
+    std::string retrieveAsString(size_t len);
+
+    // 内存池达到内存上限时返回 false，此时不会追加任何数据
+    bool append(const char *data, size_t len);
+
+    // 内存池达到内存上限、读到的数据放不下时返回 -1，savedErrno 为 ENOBUFS
+    ssize_t readFd(int fd, int *savedErrno);
+    // 最多写出 maxBytes 字节
+    ssize_t writeFd(int fd, int *savedErrno, size_t maxBytes = static_cast<size_t>(-1));
+
+    /**
+     * 数据流中的位置：累计追加的字节数与累计取出的字节数
+     * TcpConnection 用它记录特殊发送项（零拷贝数据、文件）在数据流中的位置，保证与缓冲区中的数据按顺序发送
+     */
+    uint64_t totalAppended() const { return totalAppended_; }
+    uint64_t totalRetrieved() const { return totalRetrieved_; }
+
+private:
+    struct Block {
+        char* data;
+        size_t readIndex;
+        size_t writeIndex;
+
+        size_t readableBytes() const { return writeIndex - readIndex; }
+    };
+
+    static const int kMaxWriteIovecs = 64;  // writeFd 一次最多聚合的内存块数
+
+    size_t writableBytes() const { return blocks_.empty() ? 0 : blockSize_ - blocks_.back().writeIndex; }
+    void popFront();
+
+    std::shared_ptr<BufferPool> pool_;
+    const size_t blockSize_;
+    std::deque<Block> blocks_;
+    size_t readableBytes_;
+    uint64_t totalAppended_;
+    uint64_t totalRetrieved_;
+};
+
+}
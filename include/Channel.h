@@ -5,6 +5,7 @@
 
 #include "nocopyable.h"
 #include "TimeStamp.h"
+#include "InlineFunction.h"
 
 
 namespace muduo {
@@ -13,8 +14,11 @@ class EventLoop;
 
 class Channel : public nocopyable {
 public:
-    using EventCallback = std::function<void()>;
-    using ReadEventCallback = std::function<void(TimeStamp)>;
+    // 回调一般是绑定了 this 的成员函数，32 字节足够内联存放
+    using EventCallback = InlineFunction<void(), 32>;
+    using ReadEventCallback = InlineFunction<void(TimeStamp), 32>;
+    // 处理 socket 错误队列，返回 true 表示 EPOLLERR 只是错误队列中的通知（如 MSG_ZEROCOPY 完成通知），不是真正的错误
+    using ErrorQueueCallback = InlineFunction<bool(), 32>;
 
     Channel(EventLoop* loop, int fd);
     ~Channel();
@@ -22,10 +26,11 @@ public:
     // 事件处理
     void handleEvent(TimeStamp receiveTime);
 
-    void setReadCallback(const ReadEventCallback cb) { readCallback_ = std::move(cb); }
-    void setWriteCallback(const EventCallback cb) { writeCallback_ = std::move(cb); }
-    void setErrorCallback(const EventCallback cb) { errorCallback_ = std::move(cb); }
-    void setCloseCallback(const EventCallback cb) { closeCallback_ = std::move(cb); }
+    void setReadCallback(ReadEventCallback cb) { readCallback_ = std::move(cb); }
+    void setWriteCallback(EventCallback cb) { writeCallback_ = std::move(cb); }
+    void setErrorCallback(EventCallback cb) { errorCallback_ = std::move(cb); }
+    void setCloseCallback(EventCallback cb) { closeCallback_ = std::move(cb); }
+    void setErrorQueueCallback(ErrorQueueCallback cb) { errorQueueCallback_ = std::move(cb); }
 
     // 生命期保证
     void tie(const std::shared_ptr<void>&);
@@ -76,6 +81,7 @@ private:
     EventCallback writeCallback_;
     EventCallback errorCallback_;
     EventCallback closeCallback_;
+    ErrorQueueCallback errorQueueCallback_;
 };
 
 }
@@ -13,7 +13,8 @@ class EpollPoller : public Poller {
 private:
     static const int kInitEventListSize = 16;   // epoll_wait() 的初始大小
 
-    // 将活跃事件填充到 activeChannels 中
+    // 处理 epoll_wait()/epoll_pwait2() 的返回值，将活跃事件填充到 activeChannels 中
+    TimeStamp handleEvents(int numEvents, int savedErrno, ChannelList* activeChannels);
     void fillActiveChannels(int numEvents, ChannelList* activeChannels) const;
 
     // 更新 epoll 中的事件
@@ -23,12 +24,16 @@ private:
 
     int epollfd_;
     EventList events_;  // 用于保存 epoll_wait() 返回的活跃事件
+    bool hasPwait2_;    // 内核是否支持 epoll_pwait2（5.11 起），支持时 pollNanos 精确到纳秒
 
 public:
     EpollPoller(EventLoop* loop);
     ~EpollPoller() override;
 
     TimeStamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    TimeStamp pollNanos(int64_t timeoutNs, ChannelList* activeChannels) override;
+    bool hasNanosecondTimeout() const override { return hasPwait2_; }
+    const char* name() const override { return "epoll"; }
     void updateChannel(Channel* channel) override;
     void removeChannel(Channel* channel) override;
 };
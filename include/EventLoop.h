@@ -4,9 +4,10 @@
 #include <memory>
 #include <vector>
 #include <atomic>
-#include <mutex>
+#include <cstdint>
 
 #include "TimeStamp.h"
+#include "MonoTime.h"
 #include "nocopyable.h"
 #include "CurrentThread.h"
 #include "Callbacks.h"
@@ -14,6 +15,9 @@
 #include "Channel.h"
 #include "Poller.h"
 #include "TimerQueue.h"
+#include "BufferPool.h"
+#include "PipePool.h"
+#include "MpscQueue.h"
 
 
 namespace muduo {
@@ -22,7 +26,7 @@ class TimerQueue;
 
 class EventLoop : nocopyable {
 public:
-    using Functor = std::function<void()>;
+    using Functor = Task;
 
     EventLoop();
     ~EventLoop();
@@ -32,18 +36,84 @@ public:
 
     void runInLoop(Functor cb);     // 在当前IO线程中执行cb
     void queueInLoop(Functor cb);   // 将cb放入pendingFunctors_中，唤醒IO线程执行cb
+    // 放入优先队列：下一轮循环最先执行，不受每轮任务预算限制，用于对延迟敏感的少量任务
+    void queueUrgentInLoop(Functor cb);
+
+    /**
+     * 每轮循环执行普通任务的预算，超出的任务留到下一轮，在此之前先处理 IO 事件和定时器
+     * 避免一次向大量连接广播之类的突发任务长时间阻塞 IO；maxTasks/maxSeconds 为 0 表示不限制
+     * 需要在 IO 线程中或 loop() 之前设置
+     */
+    void setFunctorBudget(size_t maxTasks, double maxSeconds) {
+        maxFunctorsPerIteration_ = maxTasks;
+        maxFunctorSecondsPerIteration_ = maxSeconds;
+    }
+    // 因超出预算而把剩余任务推迟到下一轮的次数，只应在 IO 线程中读取
+    uint64_t numFunctorBudgetExhausted() const { return numFunctorBudgetExhausted_; }
+
+    /**
+     * 忙轮询：每次有 IO 事件或跨线程任务之后，在 spinSeconds 内用 0 超时轮询，超过后才回到阻塞等待
+     * 用 CPU 换取微秒级的唤醒延迟，0 表示关闭；socketBusyPollUs 大于 0 时本 EventLoop 上的新连接设置 SO_BUSY_POLL
+     * 需要在 IO 线程中或 loop() 之前设置，通常在 ThreadInitCallback 或 EventLoopThreadPool::setBusyPoll 中设置
+     */
+    void setBusyPoll(double spinSeconds, int socketBusyPollUs = 0);
+    int socketBusyPollUs() const { return socketBusyPollUs_.load(std::memory_order_relaxed); }
+    void disableSocketBusyPoll() { socketBusyPollUs_ = 0; }    // 设置 socket 选项失败（如没有权限）时关闭，避免每个连接都失败一次
+
+    // 轮询统计，可以在任意线程读取：忙轮询窗口内的 0 超时轮询（忙等）与阻塞等待各自的次数与耗时
+    uint64_t numSpinPolls() const { return numSpinPolls_.load(std::memory_order_relaxed); }
+    // 因为还有推迟或新放入的任务而以 0 超时轮询的次数，与是否开启忙轮询无关
+    uint64_t numDeferredPolls() const { return numDeferredPolls_.load(std::memory_order_relaxed); }
+    uint64_t numBlockingPolls() const { return numBlockingPolls_.load(std::memory_order_relaxed); }
+    double spinSeconds() const { return spinNanos_.load(std::memory_order_relaxed) / 1e9; }
+    double blockSeconds() const { return blockNanos_.load(std::memory_order_relaxed) / 1e9; }
 
     TimeStamp pollReturnTime() const { return pollReturnTime_; }
+    // 同一时刻的单调时钟时间，记录活动时间、计算超时时使用，不受修改系统时间的影响
+    MonoTime pollReturnMonoTime() const { return pollReturnMonoTime_; }
+
+    void wakeup();  // 唤醒IO线程，已经有未被处理的唤醒时不重复写 eventfd
+
+    // 唤醒统计，可以在任意线程读取：wakeup() 的调用次数，以及实际写 eventfd 的次数
+    uint64_t numWakeupsRequested() const { return numWakeupsRequested_.load(std::memory_order_relaxed); }
+    uint64_t numWakeupsIssued() const { return numWakeupsIssued_.load(std::memory_order_relaxed); }
+
+    // timerfd 统计，可以在任意线程读取：定时器变化要求重新设置 timerfd 的次数，以及合并后实际调用 timerfd_settime 的次数
+    uint64_t numTimerRearmsRequested() const;
+    uint64_t numTimerRearmsIssued() const;
 
-    void wakeup();  // 唤醒IO线程
+    // Poller 所用的系统调用次数，可以在任意线程读取
+    uint64_t numPollerSyscalls() const { return poller_->numSyscalls(); }
+    // 实际使用的 Poller 实现（"epoll" 或 "io_uring"）
+    const char* pollerName() const { return poller_->name(); }
 
     void updateChannel(Channel* channel);   // 更新channel
     void removeChannel(Channel* channel);   // 移除channel
     bool hasChannel(Channel* channel);      // 判断channel是否在EventLoop中
 
     TimerId runAt(TimeStamp time, TimerCallback cb);    // 在指定时间执行cb
+    TimerId runAt(MonoTime time, TimerCallback cb);     // 在单调时钟上的指定时间执行cb，适合按上一次的时间累加的节拍定时器
     TimerId runAfter(double delay, TimerCallback cb);   // 在delay时间后执行cb
     TimerId runEvery(double interval, TimerCallback cb);    // 每隔interval时间执行cb
+    // 取消定时器，回调持有的对象随之释放；已经到期或已取消的定时器忽略，可以在任意线程调用
+    void cancel(TimerId timerId);
+
+    // 定时器时间轮的精度（默认 1ms），定时器最多晚一个精度触发；10~50us 级别的节拍、限速定时器可以设为 1~5us，可以在任意线程调用
+    void setTimerResolution(double seconds);
+
+    /**
+     * 下一个定时器在 1ms 之内到期时，由 poll 直接按纳秒精度等到它的到期时间（epoll_pwait2 或 io_uring），
+     * 省去 timerfd_settime 和读 timerfd 两次系统调用；Poller 不支持时仍使用 timerfd。默认关闭
+     * 开启时把 IO 线程的 timer slack 设为 1ns，否则内核会把 poll 的超时推迟最多 50us；
+     * 关闭或 EventLoop 析构时恢复开启前的 timer slack。只能在 IO 线程中调用
+     */
+    void setPreciseTimerWait(bool on);
+
+    // 本 EventLoop 的内存块池，供其上的 TcpConnection 分配发送缓冲区
+    const std::shared_ptr<BufferPool>& bufferPool() const { return bufferPool_; }
+
+    // 本 EventLoop 的管道池，供其上的 TcpConnection 做 splice 转发
+    const std::shared_ptr<PipePool>& pipePool() const { return pipePool_; }
 
     bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
 
@@ -67,17 +137,37 @@ private:
     const pid_t threadId_;
 
     TimeStamp pollReturnTime_;      // poll返回发生事件的时间点
+    MonoTime pollReturnMonoTime_;
+    TimeStamp lastTrimTime_;        // 上次回收内存池空闲内存块的时间点
     std::shared_ptr<Poller> poller_;    // IO复用器
     ChannelList activeChannels_;    // Poller返回的发生事件的Channel
 
     std::unique_ptr<TimerQueue> timerQueue_;    // 定时器队列
+    std::shared_ptr<BufferPool> bufferPool_;    // 内存块池
+    std::shared_ptr<PipePool> pipePool_;        // splice 转发用的管道池
 
     int wakeupFd_;
     std::shared_ptr<Channel> wakeupChannel_;
+    std::atomic_bool wakeupPending_;    // 已经写过 eventfd，IO 线程还没有开始处理这一批任务
+    std::atomic<uint64_t> numWakeupsRequested_;
+    std::atomic<uint64_t> numWakeupsIssued_;
 
-    std::mutex mutex_;
     std::atomic_bool callingPendingFunctors_;   // 是否正在执行pendingFunctors_
-    std::vector<Functor> pendingFunctors_;    // 存放需要在IO线程中执行的任务
+    MpscQueue<Functor> pendingFunctors_;      // 存放需要在IO线程中执行的任务，其他线程无锁放入
+    MpscQueue<Functor> urgentFunctors_;       // 优先执行的任务
+    size_t maxFunctorsPerIteration_;
+    double maxFunctorSecondsPerIteration_;
+    uint64_t numFunctorBudgetExhausted_;
+
+    int64_t busyPollNanos_;                 // 忙轮询窗口，0 表示关闭
+    std::atomic<int> socketBusyPollUs_;
+    std::atomic<uint64_t> numSpinPolls_;
+    std::atomic<uint64_t> numBlockingPolls_;
+    std::atomic<uint64_t> numDeferredPolls_;
+    std::atomic<int64_t> spinNanos_;
+    std::atomic<int64_t> blockNanos_;
+    bool preciseTimerWait_;
+    long savedTimerSlack_;                  // 开启精确等待前线程的 timer slack（纳秒）
 };
 
 }
\ No newline at end of file
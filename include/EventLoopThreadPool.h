@@ -20,6 +20,11 @@ public:
     ~EventLoopThreadPool();
 
     void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+    // 在 start 之前调用，为每个 IO 线程（单线程模型下为 baseLoop）开启忙轮询，参数见 EventLoop::setBusyPoll
+    void setBusyPoll(double spinSeconds, int socketBusyPollUs = 0) {
+        busyPollSeconds_ = spinSeconds;
+        socketBusyPollUs_ = socketBusyPollUs;
+    }
     void start(const ThreadInitCallback& cb = ThreadInitCallback());
 
     EventLoop* getNextLoop(const std::string& key);
@@ -36,6 +41,8 @@ private:
     bool started_;
     int numThreads_;  // 线程池中线程数
     int next_;  // 下一个EventLoop的索引
+    double busyPollSeconds_;
+    int socketBusyPollUs_;
     std::vector<std::unique_ptr<EventLoopThread>> threads_;  // 线程池
     std::vector<EventLoop*> loops_;  // 线程池中所有EventLoop
     ConsistenHash consistenHash_;  // 一致性哈希算法
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "nocopyable.h"
+
+namespace muduo {
+
+template <typename Signature, size_t kInlineSize = 64>
+class InlineFunction;
+
+/**
+ * @brief 只能移动的可调用对象包装，用来替代 std::function
+ * @note libstdc++ 的 std::function 只能内联存放 16 字节，绑定了成员函数指针和 shared_ptr<TcpConnection> 的
+ * std::bind 对象就放不下，每次 runInLoop/queueInLoop 都要堆分配一次
+ * InlineFunction 内联存放不超过 kInlineSize 字节的可调用对象，更大的才退化为堆分配
+ * 不支持拷贝，从而可以存放只能移动的对象，也避免了意外的深拷贝
+ */
+template <typename R, typename... Args, size_t kInlineSize>
+class InlineFunction<R(Args...), kInlineSize> : nocopyable {
+public:
+    InlineFunction() noexcept : ops_(nullptr) {}
+    InlineFunction(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+    // 与 std::function 一样，返回类型为 void 时丢弃被包装对象的返回值；空的 std::function 或函数指针得到空的 InlineFunction
+    template <typename F,
+              typename D = typename std::decay<F>::type,
+              typename = typename std::enable_if<
+                  !std::is_same<D, InlineFunction>::value &&
+                  (std::is_void<R>::value ||
+                   std::is_convertible<decltype(std::declval<D&>()(std::declval<Args>()...)), R>::value)>::type>
+    InlineFunction(F&& f) : ops_(nullptr) {
+        if (!isNull(f)) {
+            construct<D>(std::forward<F>(f));
+        }
+    }
+
+    InlineFunction(InlineFunction&& other) : ops_(nullptr) {
+        moveFrom(other);
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    ~InlineFunction() { reset(); }
+
+    // 与 std::function 一样，const 的调用也可以修改被包装对象的状态
+    R operator()(Args... args) const {
+        return ops_->invoke(&storage_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // 被包装的对象是否内联存放，主要用于测试
+    bool isInline() const noexcept { return ops_ != nullptr && ops_->isInline; }
+
+private:
+    using Storage = typename std::aligned_storage<kInlineSize, alignof(void*)>::type;
+
+    struct Ops {
+        R (*invoke)(Storage* storage, Args&&... args);
+        void (*move)(Storage* dst, Storage* src);   // 在 dst 上移动构造并析构 src
+        void (*destroy)(Storage* storage);
+        bool isInline;
+    };
+
+    template <typename Ret, typename F>
+    struct Call {
+        static Ret call(F& f, Args&&... args) { return f(std::forward<Args>(args)...); }
+    };
+
+    template <typename F>
+    struct Call<void, F> {
+        static void call(F& f, Args&&... args) { f(std::forward<Args>(args)...); }
+    };
+
+    template <typename F>
+    struct InlineOps {
+        static F* get(Storage* s) { return reinterpret_cast<F*>(s); }
+        static R invoke(Storage* s, Args&&... args) { return Call<R, F>::call(*get(s), std::forward<Args>(args)...); }
+        static void move(Storage* dst, Storage* src) {
+            ::new (static_cast<void*>(dst)) F(std::move(*get(src)));
+            get(src)->~F();
+        }
+        static void destroy(Storage* s) { get(s)->~F(); }
+        static const Ops ops;
+    };
+
+    // 放不下的对象存放在堆上，Storage 中只保存指针
+    template <typename F>
+    struct HeapOps {
+        static F*& get(Storage* s) { return *reinterpret_cast<F**>(s); }
+        static R invoke(Storage* s, Args&&... args) { return Call<R, F>::call(*get(s), std::forward<Args>(args)...); }
+        static void move(Storage* dst, Storage* src) {
+            ::new (static_cast<void*>(dst)) F*(get(src));
+        }
+        static void destroy(Storage* s) { delete get(s); }
+        static const Ops ops;
+    };
+
+    template <typename F>
+    struct FitsInline {
+        static const bool value = sizeof(F) <= sizeof(Storage) &&
+                                  alignof(Storage) % alignof(F) == 0 &&
+                                  std::is_move_constructible<F>::value;
+    };
+
+    template <typename F, typename G>
+    typename std::enable_if<FitsInline<F>::value>::type construct(G&& f) {
+        ::new (static_cast<void*>(&storage_)) F(std::forward<G>(f));
+        ops_ = &InlineOps<F>::ops;
+    }
+
+    template <typename F, typename G>
+    typename std::enable_if<!FitsInline<F>::value>::type construct(G&& f) {
+        ::new (static_cast<void*>(&storage_)) F*(new F(std::forward<G>(f)));
+        ops_ = &HeapOps<F>::ops;
+    }
+
+    template <typename F>
+    static bool isNull(const F&) { return false; }
+    template <typename F>
+    static bool isNull(F* f) { return f == nullptr; }
+    template <typename Sig>
+    static bool isNull(const std::function<Sig>& f) { return !f; }
+
+    void moveFrom(InlineFunction& other) {
+        if (other.ops_ != nullptr) {
+            other.ops_->move(&storage_, &other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    void reset() {
+        if (ops_ != nullptr) {
+            const Ops* ops = ops_;
+            ops_ = nullptr;
+            ops->destroy(&storage_);
+        }
+    }
+
+    const Ops* ops_;
+    mutable Storage storage_;
+};
+
+template <typename R, typename... Args, size_t kInlineSize>
+template <typename F>
+const typename InlineFunction<R(Args...), kInlineSize>::Ops
+InlineFunction<R(Args...), kInlineSize>::InlineOps<F>::ops = {
+    &InlineOps<F>::invoke, &InlineOps<F>::move, &InlineOps<F>::destroy, true
+};
+
+template <typename R, typename... Args, size_t kInlineSize>
+template <typename F>
+const typename InlineFunction<R(Args...), kInlineSize>::Ops
+InlineFunction<R(Args...), kInlineSize>::HeapOps<F>::ops = {
+    &HeapOps<F>::invoke, &HeapOps<F>::move, &HeapOps<F>::destroy, false
+};
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <vector>
+#include <cstdint>
+
+#include "TimeStamp.h"
+#include "Poller.h"
+
+namespace muduo {
+
+/**
+ * @brief 实验性的、基于 io_uring 的 Poller，设置环境变量 MUDUO_USE_IO_URING 后启用，内核不支持时退回 EpollPoller
+ * @note 每个 Channel 对应一个一次性的 IORING_OP_POLL_ADD，触发后在下一次 poll() 时按当前关注的事件重新提交
+ * 对仍然就绪的 fd，重新提交的 poll 立即完成，因此与 EpollPoller 一样是水平触发
+ * 增删改事件写入提交队列，与等待事件一起由 io_uring_enter() 提交
+ * 它只替换了就绪通知：accept、read、write 仍由 Acceptor 和 TcpConnection 直接调用，没有多次触发的 accept/recv、
+ * 注册的缓冲区环或批量的写请求，所以不会减少收发数据的系统调用，也不保证比 EpollPoller 快，默认不启用
+ * 直接使用系统调用和共享内存环形队列，不依赖 liburing
+ */
+class IoUringPoller : public Poller {
+
+private:
+    static const unsigned kRingEntries = 1024;  // 提交队列的大小，完成队列为其两倍
+
+    // 每个 fd 的状态，以 fd 为下标
+    struct Entry {
+        Entry() : channel(nullptr), seq(0), armedEvents(0), dirty(false) {}
+
+        Channel* channel;
+        uint32_t seq;       // 当前已提交的 poll 的序号，0 表示没有已提交的 poll
+        int armedEvents;    // 已提交的 poll 关注的事件
+        bool dirty;         // 已在 dirty_ 中，等待下一次 poll() 时按当前关注的事件重新提交
+    };
+
+    bool setupRing();
+    Entry& entry(int fd);
+    void markDirty(int fd);
+
+    // 把 dirty_ 中的 Channel 按当前关注的事件写入提交队列
+    void flushUpdates();
+
+    io_uring_sqe* getSqe();
+    void queuePollAdd(int fd, Entry& e, int events);
+    void queuePollRemove(int fd, const Entry& e);
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize);
+
+    // 取出完成队列中的事件，将活跃事件填充到 activeChannels 中
+    void fillActiveChannels(ChannelList* activeChannels);
+
+    int ringFd_;
+    void* sqRing_;
+    size_t sqRingSize_;
+    void* cqRing_;
+    size_t cqRingSize_;
+    io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    // 映射到共享内存中的环形队列字段
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned* sqArray_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+
+    unsigned sqLocalTail_;      // 本地的提交队列尾，io_uring_enter() 前才写回共享内存
+    unsigned toSubmit_;         // 已写入提交队列，还没有交给内核的数量
+    uint32_t nextSeq_;
+    std::vector<Entry> entries_;
+    std::vector<int> dirty_;
+    std::vector<int> updating_;     // flushUpdates() 中与 dirty_ 交换，避免每轮分配
+
+public:
+    IoUringPoller(EventLoop* loop);
+    ~IoUringPoller() override;
+
+    // io_uring 是否初始化成功，失败时（内核过旧、被 sysctl 或 seccomp 禁用）由 newDefaultPoller 改用 EpollPoller
+    bool valid() const { return ringFd_ >= 0; }
+
+    TimeStamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    TimeStamp pollNanos(int64_t timeoutNs, ChannelList* activeChannels) override;
+    bool hasNanosecondTimeout() const override { return true; }
+    const char* name() const override { return "io_uring"; }
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+    // 撤销所有已提交的 poll，再次 loop() 时重新提交
+    void stopPolling() override;
+};
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "Buffer.h"
+#include "Callbacks.h"
+#include "StringPiece.h"
+#include "TimeStamp.h"
+#include "nocopyable.h"
+
+namespace muduo {
+
+/**
+ * @brief 长度前缀编解码器：每个消息前面带 4 字节网络字节序的长度头
+ * @note 位于 TcpConnection 与用户之间，把 onMessage 设置为 TcpServer 的 MessageCallback 即可
+ * 解码：直接在 inputBuffer_ 上切出消息体的 StringPiece，不做中间拷贝，一次 handleRead 读到的所有完整消息合并成一次回调
+ * 编码：在 IO 线程内直接把长度头和消息体写进发送缓冲区，在批量回调中发送的回复会在回调返回后合并成一次 writev
+ * 长度超过 maxFrameSize 的消息视为协议错误，直接断开连接
+ *
+ * 一个编解码器可以被多个 IO 线程共享，回调在各连接所属的 IO 线程中执行
+ */
+class LengthHeaderCodec : nocopyable {
+public:
+    // frames 中的视图指向 inputBuffer_，只在回调期间有效，需要保留时应自行拷贝
+    using FrameBatchCallback = std::function<void(const TcpConnectionPtr&, const std::vector<StringPiece>& frames, TimeStamp)>;
+
+    static const size_t kHeaderLen = sizeof(int32_t);
+    static const size_t kDefaultMaxFrameSize = 64 * 1024 * 1024;
+
+    explicit LengthHeaderCodec(const FrameBatchCallback& cb, size_t maxFrameSize = kDefaultMaxFrameSize)
+        : frameBatchCallback_(cb),
+          maxFrameSize_(maxFrameSize) {}
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, TimeStamp receiveTime);
+
+    // 发送一个消息，可以在任意线程调用
+    void send(const TcpConnectionPtr& conn, const StringPiece& frame);
+
+    // body 中的全部可读数据作为一个消息发送，长度头写在 body 前部的预留空间中，发送后 body 被清空
+    void send(const TcpConnectionPtr& conn, Buffer* body);
+
+    // 把一个消息编码追加到 buf 末尾
+    static void encode(Buffer* buf, const StringPiece& frame);
+
+    size_t maxFrameSize() const { return maxFrameSize_; }
+
+private:
+    FrameBatchCallback frameBatchCallback_;
+    const size_t maxFrameSize_;
+};
+
+}
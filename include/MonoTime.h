@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include "TimeStamp.h"
+
+namespace muduo {
+
+/**
+ * @brief 单调时钟（CLOCK_MONOTONIC）上的纳秒时间点，用于定时器的到期时间
+ * @note 与 TimeStamp 不同，不受修改系统时间的影响，与 timerfd、epoll_pwait2 使用同一个时钟，精度为纳秒
+ * std::chrono::steady_clock 在 Linux 上同样基于 CLOCK_MONOTONIC，两者的时间点可以直接换算
+ */
+class MonoTime {
+public:
+    MonoTime() : nanoSeconds_(0) {}
+
+    explicit MonoTime(int64_t nanoSeconds) : nanoSeconds_(nanoSeconds) {}
+
+    static MonoTime now();
+    static MonoTime invalid() { return MonoTime(); }
+
+    // 墙上时间 when 对应的单调时钟时间点，按当前两个时钟的差值换算
+    static MonoTime fromTimeStamp(TimeStamp when);
+
+    bool valid() const { return nanoSeconds_ > 0; }
+
+    int64_t nanoSeconds() const { return nanoSeconds_; }
+
+    static const int64_t kNanoSecondsPerSecond = 1000 * 1000 * 1000;
+
+private:
+    int64_t nanoSeconds_;
+};
+
+inline bool operator<(MonoTime lhs, MonoTime rhs) {
+    return lhs.nanoSeconds() < rhs.nanoSeconds();
+}
+
+inline bool operator==(MonoTime lhs, MonoTime rhs) {
+    return lhs.nanoSeconds() == rhs.nanoSeconds();
+}
+
+inline double timeDifference(MonoTime high, MonoTime low) {
+    return static_cast<double>(high.nanoSeconds() - low.nanoSeconds()) / MonoTime::kNanoSecondsPerSecond;
+}
+
+inline MonoTime addTime(MonoTime time, double seconds) {
+    return MonoTime(time.nanoSeconds() + static_cast<int64_t>(seconds * MonoTime::kNanoSecondsPerSecond));
+}
+
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "nocopyable.h"
+
+namespace muduo {
+
+/**
+ * @brief 无锁的多生产者单消费者队列（Vyukov 侵入式链表）
+ * @note 生产者只做一次 exchange 把节点挂到队尾，不加锁也不重试；消费者从队首逐个取出
+ * 消费者每次只取调用时已经在队列中的元素，与 swap 整个 vector 一样按批消费，消费期间新放入的元素留到下一批
+ * T 需要可以默认构造：元素被取出后立即析构其内容，节点本身留作下一次的哨兵
+ *
+ * 节点回收：消费者把用过的节点整串挂回同类型队列共享的空闲链表，生产者的线程本地缓存用完时一次取走整个空闲链表，
+ * 稳定运行后 push 不再分配内存；空闲链表只有整串挂入和整体取走两种操作，不存在 ABA 问题
+ * 空闲链表最多保留 kMaxFreeNodes 个节点，超出的部分在回收时直接释放；线程本地缓存只在用完时取走一次空闲链表，
+ * 因此同样不超过 kMaxFreeNodes 个。一次突发的大量投递不会让节点永久占着内存
+ */
+template <typename T>
+class MpscQueue : nocopyable {
+public:
+    MpscQueue() : head_(new Node()), tail_(head_) {}
+
+    ~MpscQueue() {
+        consumeAll([](T&) {});
+        recycle(head_, head_, 1);
+    }
+
+    // 可以在任意线程调用
+    void push(T value) {
+        Node* node = allocNode(std::move(value));
+        Node* prev = tail_.exchange(node, std::memory_order_acq_rel);
+        // exchange 与下面的 store 之间，消费者看到的队列在 prev 处暂时断开，它会停在这里，等下一批再取
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 只能由消费者调用：取走调用时已经在队列中的元素，按放入的先后顺序逐个交给 f，返回元素个数
+    template <typename F>
+    size_t consumeAll(F&& f) {
+        return consumeWhile([&f](T& value) {
+            f(value);
+            return true;
+        });
+    }
+
+    // 与 consumeAll 相同，但 f 返回 false 时在处理完当前元素后停止，剩下的元素留在队列中
+    template <typename F>
+    size_t consumeWhile(F&& f) {
+        Node* last = tail_.load(std::memory_order_acquire);
+        Node* freeFirst = head_;
+        Node* freeLast = nullptr;
+        size_t count = 0;
+        while (head_ != last) {
+            Node* next = head_->next.load(std::memory_order_acquire);
+            if (next == nullptr) {  // 生产者还没有链接上，留到下一批
+                break;
+            }
+            freeLast = head_;
+            head_ = next;
+            bool more = f(next->value);
+            next->value = T();
+            ++count;
+            if (!more) {
+                break;
+            }
+        }
+        // [freeFirst, freeLast] 是已经用过的哨兵，整串回收
+        if (freeLast != nullptr) {
+            recycle(freeFirst, freeLast, count);
+        }
+        return count;
+    }
+
+    // 只能由消费者调用
+    bool empty() const { return tail_.load(std::memory_order_acquire) == head_; }
+
+    // 同类型队列共享的空闲链表加上当前线程本地缓存中的节点数
+    static size_t cachedNodes() { return freeCount().load(std::memory_order_relaxed) + localCache().count; }
+
+    static const size_t kMaxFreeNodes = 4096;
+
+private:
+    struct Node {
+        Node() : next(nullptr) {}
+        explicit Node(T&& v) : value(std::move(v)), next(nullptr) {}
+
+        T value;
+        std::atomic<Node*> next;
+    };
+
+    // 线程本地的空闲节点缓存，线程退出时释放
+    struct LocalCache {
+        LocalCache() : head(nullptr), count(0) {}
+        ~LocalCache() {
+            while (head != nullptr) {
+                Node* next = head->next.load(std::memory_order_relaxed);
+                delete head;
+                head = next;
+            }
+        }
+
+        Node* head;
+        size_t count;
+    };
+
+    static LocalCache& localCache() {
+        static thread_local LocalCache cache;
+        return cache;
+    }
+
+    static std::atomic<Node*>& freeList() {
+        static std::atomic<Node*> list(nullptr);
+        return list;
+    }
+
+    // 空闲链表中的节点数，挂入前先加、取走后再减，因此不会小于实际的节点数
+    static std::atomic<size_t>& freeCount() {
+        static std::atomic<size_t> count(0);
+        return count;
+    }
+
+    static Node* allocNode(T&& value) {
+        LocalCache& cache = localCache();
+        if (cache.head == nullptr) {
+            refill(cache);
+        }
+        Node* node = cache.head;
+        if (node == nullptr) {
+            return new Node(std::move(value));
+        }
+        cache.head = node->next.load(std::memory_order_relaxed);
+        --cache.count;
+        node->value = std::move(value);
+        node->next.store(nullptr, std::memory_order_relaxed);
+        return node;
+    }
+
+    // 取走整个空闲链表作为本地缓存
+    static void refill(LocalCache& cache) {
+        Node* first = freeList().exchange(nullptr, std::memory_order_acquire);
+        size_t taken = 0;
+        for (Node* node = first; node != nullptr; node = node->next.load(std::memory_order_relaxed)) {
+            ++taken;
+        }
+        freeCount().fetch_sub(taken, std::memory_order_relaxed);
+        cache.head = first;
+        cache.count = taken;
+    }
+
+    // 把 first 到 last 的 n 个节点挂回空闲链表，超出 kMaxFreeNodes 的部分直接释放
+    static void recycle(Node* first, Node* last, size_t n) {
+        size_t before = freeCount().fetch_add(n, std::memory_order_relaxed);
+        size_t keep = before >= kMaxFreeNodes ? 0 : std::min(n, kMaxFreeNodes - before);
+        if (keep < n) {
+            freeCount().fetch_sub(n - keep, std::memory_order_relaxed);
+            Node* node = first;
+            Node* keepLast = nullptr;
+            for (size_t i = 0; i < keep; ++i) {
+                keepLast = node;
+                node = node->next.load(std::memory_order_relaxed);
+            }
+            // 从 node 开始到 last 的节点都不再保留
+            while (true) {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                bool isLast = node == last;
+                delete node;
+                if (isLast) {
+                    break;
+                }
+                node = next;
+            }
+            if (keepLast == nullptr) {
+                return;
+            }
+            last = keepLast;
+        }
+        Node* old = freeList().load(std::memory_order_relaxed);
+        do {
+            last->next.store(old, std::memory_order_relaxed);
+        } while (!freeList().compare_exchange_weak(old, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    Node* head_;                // 哨兵节点，其后是最早放入的元素，只由消费者访问
+    std::atomic<Node*> tail_;
+};
+
+}
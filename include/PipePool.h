@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+#include "nocopyable.h"
+
+namespace muduo {
+
+/**
+ * @brief 管道池，为 splice 转发提供内核中转缓冲区
+ * @note 每个 EventLoop 持有一个，创建管道以及调整管道容量都需要系统调用，空的管道用完后缓存起来复用
+ * 归还时仍有数据的管道直接关闭；与 BufferPool 一样，管道可能随 TcpConnection 在其他线程释放，空闲列表用互斥锁保护
+ */
+class PipePool : nocopyable, public std::enable_shared_from_this<PipePool> {
+public:
+    struct Pipe {
+        int readFd;
+        int writeFd;
+        size_t capacity;    // 管道容量
+        size_t buffered;    // 已经写入管道、还没有被读走的字节数
+    };
+
+    static const size_t kDefaultPipeSize = 1024 * 1024;    // 期望的管道容量，受 /proc/sys/fs/pipe-max-size 限制
+    static const size_t kDefaultMaxIdlePipes = 64;
+
+    explicit PipePool(size_t pipeSize = kDefaultPipeSize, size_t maxIdlePipes = kDefaultMaxIdlePipes);
+    ~PipePool();
+
+    // 取出一个空管道，用完后随 shared_ptr 自动归还，失败时返回 nullptr
+    std::shared_ptr<Pipe> acquire();
+
+    size_t numIdle() const;
+
+private:
+    void release(Pipe* pipe);
+    static void closePipe(Pipe* pipe);
+
+    const size_t pipeSize_;
+    const size_t maxIdlePipes_;
+    mutable std::mutex mutex_;
+    std::vector<Pipe*> idle_;
+};
+
+}
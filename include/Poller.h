@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <unordered_map>
+#include <atomic>
+#include <cstdint>
 
 #include "nocopyable.h"
 #include "TimeStamp.h"
@@ -21,12 +23,23 @@ public:
 
     // 给所有 IO 复用模块提供的接口
     virtual TimeStamp poll(int timeoutMs, ChannelList* activeChannels) = 0;
+    // 等待时间精确到纳秒的 poll，默认向上取整到毫秒后调用 poll()
+    virtual TimeStamp pollNanos(int64_t timeoutNs, ChannelList* activeChannels);
+    // pollNanos 是否真正精确到纳秒，不支持时 EventLoop 用 timerfd 处理即将到期的定时器
+    virtual bool hasNanosecondTimeout() const { return false; }
+    // 实现的名字（"epoll"、"io_uring"），newDefaultPoller 可能在 io_uring 不可用时退回 epoll
+    virtual const char* name() const = 0;
     virtual void updateChannel(Channel* channel) = 0;
     virtual void removeChannel(Channel* channel) = 0;
+    // EventLoop::loop() 返回前在 IO 线程中调用，释放只能由该线程完成的资源
+    virtual void stopPolling() {}
 
     // 判断是否有该 Channel
     bool hasChannel(Channel* channel) const;
 
+    // 等待事件与增删改事件所用的系统调用次数，可以在任意线程读取
+    uint64_t numSyscalls() const { return numSyscalls_.load(std::memory_order_relaxed); }
+
     // EventLoop 用于获取 Poller 的实例
     static Poller* newDefaultPoller(EventLoop* loop);
     
@@ -35,6 +48,7 @@ protected:
     using ChannelMap = std::unordered_map<int, Channel*>;
 
     ChannelMap channels_;
+    std::atomic<uint64_t> numSyscalls_;
 
 private:
     EventLoop* ownerLoop_;
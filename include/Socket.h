@@ -21,6 +21,11 @@ public:
     void setReusePort(bool on);
     void setKeepAlive(bool on);
     void setTcpNoDelay(bool on);
+    bool setZeroCopy(bool on);     // SO_ZEROCOPY，内核不支持时返回 false
+    // SO_LINGER 设为 0 秒：close 时直接发送 RST 并丢弃发送队列中的数据
+    void setAbortOnClose();
+    // SO_BUSY_POLL：阻塞读取时在网卡队列上忙等 usec 微秒，prefer 时再设置 SO_PREFER_BUSY_POLL；超过系统上限需要 CAP_NET_ADMIN，失败时返回 false
+    bool setBusyPoll(int usec, bool prefer);
     
 private:
     const int sockfd_;
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <ostream>
+
+namespace muduo {
+
+/**
+ * @brief 不持有内存的字符串视图（C++11 下 std::string_view 的替代品）
+ * @note 只记录指针和长度，不拷贝数据，使用者需要保证底层内存在使用期间有效
+ * 可以由 const char* 和 std::string 隐式构造，作为只读字符串参数时避免构造临时 std::string
+ */
+class StringPiece {
+public:
+    StringPiece() : ptr_(nullptr), length_(0) {}
+    StringPiece(const char* str) : ptr_(str), length_(str ? ::strlen(str) : 0) {}
+    StringPiece(const std::string& str) : ptr_(str.data()), length_(str.size()) {}
+    StringPiece(const char* offset, size_t len) : ptr_(offset), length_(len) {}
+
+    const char* data() const { return ptr_; }
+    size_t size() const { return length_; }
+    bool empty() const { return length_ == 0; }
+    const char* begin() const { return ptr_; }
+    const char* end() const { return ptr_ + length_; }
+
+    char operator[](size_t i) const { return ptr_[i]; }
+
+    void clear() { ptr_ = nullptr; length_ = 0; }
+    void set(const char* data, size_t len) { ptr_ = data; length_ = len; }
+
+    void remove_prefix(size_t n) { ptr_ += n; length_ -= n; }
+    void remove_suffix(size_t n) { length_ -= n; }
+
+    bool starts_with(const StringPiece& x) const {
+        return length_ >= x.length_ && ::memcmp(ptr_, x.ptr_, x.length_) == 0;
+    }
+
+    std::string as_string() const { return std::string(ptr_, length_); }
+
+    bool operator==(const StringPiece& x) const {
+        return length_ == x.length_ && ::memcmp(ptr_, x.ptr_, length_) == 0;
+    }
+    bool operator!=(const StringPiece& x) const { return !(*this == x); }
+
+private:
+    const char* ptr_;
+    size_t length_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const StringPiece& piece) {
+    return os.write(piece.data(), piece.size());
+}
+
+}
@@ -1,14 +1,23 @@
 #pragma once
 
 #include <memory>
+#include <deque>
+#include <atomic>
+#include <cstdint>
+#include <sys/uio.h>
 
 #include "Buffer.h"
+#include "ChainBuffer.h"
+#include "StringPiece.h"
 #include "TimeStamp.h"
+#include "MonoTime.h"
 #include "Acceptor.h"
 #include "InetAddress.h"
 #include "Callbacks.h"
 #include "nocopyable.h"
 #include "EventLoop.h"
+#include "PipePool.h"
+#include "TimerId.h"
 
 namespace muduo {
 
@@ -24,20 +33,101 @@ public:
 
     bool connected() const { return state_ == kConnected; }
 
-    void send(const std::string& buf);
+    // 发送数据，std::string 左值会隐式转换为 StringPiece，在 IO 线程内调用时不会产生中间拷贝，跨线程时拷贝一份
+    void send(const StringPiece& message);
+    void send(const char* message) { send(StringPiece(message)); }
+    void send(const void* data, size_t len);
+    void send(Buffer* buf);     // 发送 buf 中的全部可读数据并清空 buf，在 IO 线程内调用时不会产生中间拷贝
+
+    // 转移所有权发送：跨线程时把数据移动进任务队列，不拷贝；调用后 message 处于有效但未指定的状态，buf 被清空
+    void send(std::string&& message);
+    void send(Buffer&& buf);
+    // 聚集发送多个分片（如协议头 + 消息体），在 IO 线程内调用时一次 writev 写出，不需要先拼接成连续内存
+    void send(const struct iovec* iov, int iovcnt);
+    // 通过 sendfile 发送文件的 [offset, offset + count)，与其他 send 的数据按调用顺序发送，fd 需要保持打开直到发送完毕
     void sendFile(int fd, off_t offset, size_t count);
 
+    /**
+     * 直接访问发送缓冲区，只能在 IO 线程内调用，供编解码器等把数据直接编码进发送缓冲区，省去中间拷贝
+     * 写入后需要调用 flush() 发送，否则数据会一直留在缓冲区中
+     * 注意发送缓冲区是 ChainBuffer 而不是 Buffer：只有 append/peek/retrieve 一类接口，没有 prepend 和 ensureWritableBytes，
+     * 且内存池达到上限时 append 返回 false；需要 Buffer 接口的代码应先编码到自己的 Buffer 中再调用 send(Buffer*)
+     */
+    ChainBuffer* outputBuffer() { return &outputBuffer_; }
+
+    // 把发送缓冲区中的数据尽量写出，写不完的等待可写事件，只能在 IO 线程内调用
+    void flush();
+
+    /**
+     * 开启后同一轮事件循环中的多次 send 只追加到发送缓冲区，事件处理完毕后合并成一次 writev 写出
+     * 适合一个响应分多次 send 的请求/响应服务，需要在 IO 线程中或连接建立之前设置
+     */
+    void setAutoCork(bool on);
+    bool autoCork() const { return autoCork_; }
+
+    // 统计信息，只应在 IO 线程中读取：send 调用次数，以及实际发起的 write/writev/sendfile 系统调用次数
+    uint64_t numSendCalls() const { return numSendCalls_; }
+    uint64_t numWriteSyscalls() const { return numWriteSyscalls_; }
+
+    /**
+     * 通过 send(std::string&&)/send(Buffer&&) 转移了所有权、且不小于 threshold 字节的数据使用 MSG_ZEROCOPY 发送
+     * 内核在错误队列中送回完成通知之前，数据由连接持有；threshold 为 0 表示关闭，内核不支持 SO_ZEROCOPY 时返回 false
+     * 注意回环连接上内核会退化为拷贝（numZeroCopyCopied 计数），只有真实网卡才能省去拷贝
+     */
+    bool setZeroCopyThreshold(size_t threshold);
+    size_t zeroCopyThreshold() const { return zeroCopyThreshold_; }
+
+    // 零拷贝统计，只应在 IO 线程中读取：发起的零拷贝 send 次数、收到的完成通知数、其中内核退化为拷贝的次数
+    uint64_t numZeroCopySends() const { return numZeroCopySends_; }
+    uint64_t numZeroCopyCompletions() const { return numZeroCopyCompletions_; }
+    uint64_t numZeroCopyCopied() const { return numZeroCopyCopied_; }
+
+    /**
+     * 代理模式：此后从本连接读到的数据不再交给 MessageCallback，而是经由管道池中的管道 splice 到 peer，数据不进入用户态
+     * 管道容量就是转发中的数据上限，管道写满时暂停读取，peer 发送出去后恢复，两端速度不一致时内存不会堆积
+     * 转发的数据同样计入 peer 的高低水位：peer 越过高水位时也暂停读取，降到低水位后恢复，peer 的水位回调照常触发
+     * 读到 EOF 时关闭 peer 的写端（半关闭），两个方向都结束后断开；异常断开时连同 peer 一起断开
+     * 双向代理需要两端各调用一次；peer 必须属于同一个 EventLoop，已经在 inputBuffer_ 中的数据先原样转发
+     */
+    void spliceTo(const TcpConnectionPtr& peer);
+
+    /**
+     * 暂停/恢复读取，可以在任意线程调用；暂停期间数据留在内核接收缓冲区，对端的发送窗口随之收缩
+     * 与高低水位回调配合实现端到端的背压：下游连接的发送缓冲区超过高水位时暂停读取上游，降到低水位时恢复
+     */
+    void startRead();
+    void stopRead();
+    bool isReading() const { return reading_; }     // 只应在 IO 线程中读取
+
+    /**
+     * 空闲超时，单位秒，0 表示不检测对应类型；需要在 IO 线程中或连接建立之前设置
+     * 读写时只记录一个时间戳，由每个连接一个的定时器按最早的截止时间懒惰检查：到期时若期间有过读写，
+     * 按最后一次读写的时间重新计算截止时间再次定时，因此每个超时周期最多触发一次定时器，与消息数量无关
+     * 空闲时调用 IdleCallback，之后仍然空闲的话每隔一个超时周期再调用一次；没有设置回调时直接断开连接
+     */
+    void setIdleTimeout(double readerIdleSeconds, double writerIdleSeconds, double allIdleSeconds);
+    void setIdleCallback(const IdleCallback& cb) { idleCallback_ = cb; }
+
     // 关闭半连接
     void shutdown();
+    // 不等待发送缓冲区写完，直接断开连接
+    void forceClose();
 
     void setConnectionCallback(const ConnectionCallback& cb) { connectionCallback_ = cb; }
     void setMessageCallback(const MessageCallback& cb) { messageCallback_ = cb; }
     void setWriteCompleteCallback(const WriteCompleteCallback& cb) { writeCompleteCallback_ = cb; }
     void setCloseCallback(const CloseCallback& cb) { closeCallback_ = cb; }
+    // 待发送的数据（包括排队中的文件、零拷贝和 splice 转发的数据）增长到 highWaterMark 时回调一次，
+    // 之后降到低水位（默认 0）以下才会再次触发
     void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark) {
         highWaterMarkCallback_ = cb;
         highWaterMark_ = highWaterMark;
     }
+    // 触发过高水位回调之后，待发送的数据降到 lowWaterMark 及以下时回调一次，之后再次超过高水位才会重新触发
+    void setLowWaterMarkCallback(const LowWaterMarkCallback& cb, size_t lowWaterMark) {
+        lowWaterMarkCallback_ = cb;
+        lowWaterMark_ = lowWaterMark;
+    }
 
     void connectEstablished();
     void connectDestroyed();
@@ -45,21 +135,89 @@ public:
 private:
     enum StateE { kConnecting, kConnected, kDisconnecting, kDisconnected };
 
+    /**
+     * 输出队列中的特殊发送项，不经过 outputBuffer_
+     * streamOffset 记录入队时 outputBuffer_ 的 totalAppended()，在它之前追加的数据写完后才发送该项，
+     * 在它之后追加的数据要等该项发送完毕，从而与缓冲区中的数据保持发送顺序
+     */
+    struct OutputEntry {
+        enum Type { kZeroCopy, kFile, kPipe };
+
+        Type type;
+        uint64_t streamOffset;
+        size_t len;         // 总字节数
+        size_t sent;        // 已发送字节数
+
+        // kZeroCopy：owner 持有数据（只移动、不调用），出队时交给最后一次零拷贝 send 的记录，直到内核送回完成通知
+        Task owner;
+        const char* data;
+        bool zeroCopySent;  // 是否有以 MSG_ZEROCOPY 发出的部分
+
+        // kFile：下一次 sendfile 的文件位置
+        int fileFd;
+        off_t fileOffset;
+
+        // kPipe：从 source 的管道 splice 到 socket，每次写出后通知 source 管道有了空间
+        std::shared_ptr<PipePool::Pipe> pipe;
+        std::weak_ptr<TcpConnection> source;
+    };
+
+    // 已经以 MSG_ZEROCOPY 发出、等待完成通知的 send 调用，seq 与内核的计数一一对应
+    // 按 seq 顺序释放：只有前面的记录都完成之后才出队，owner 持有的数据不会早于它之前的 send 被释放
+    struct ZeroCopyInflight {
+        uint32_t seq;
+        bool done;
+        Task owner;
+    };
+
     void setState(StateE s) { state_ = s; }
 
     void handleRead(TimeStamp receiveTime); 
     void handleWrite();
     void handleClose();
     void handleError();
+    void checkHighWaterMark(size_t pendingBytes);
+    void checkHighWaterMark() { checkHighWaterMark(pendingOutputBytes()); }
+    void checkLowWaterMark();
 
+    void sendInLoop(const StringPiece& message);
     void sendInLoop(const void *data, size_t len);
+    void sendBufferInLoop(const Buffer& buf);
+    void sendZeroCopyInLoop(std::string& message);
+    void sendZeroCopyInLoop(Buffer& buf);
+    void queueZeroCopy(Task owner, const char* data, size_t len);
+    void retireEntry(OutputEntry& entry);
+
+    bool outputPending() const { return outputBuffer_.readableBytes() > 0 || !outputQueue_.empty(); }
+    // 待发送的字节数：发送缓冲区中的数据加上输出队列中各发送项未发送的部分，高低水位都按它计算
+    size_t pendingOutputBytes() const { return outputBuffer_.readableBytes() + queuedBytes_; }
+    bool drainOutput();
+    bool writeOutput();
+    void abortOutput();
+    bool writeEntry(OutputEntry& entry, bool* faultError);
+    bool handleErrorQueue();
+    void lingerZeroCopy(double interval, double waited);
+    void sendInLoop(const struct iovec* iov, int iovcnt);
+    void queueCorkedFlush();
+    void corkedFlush();
     void shutdownInLoop();
+    void forceCloseInLoop();
+    void startReadInLoop();
+    void stopReadInLoop();
     void sendFileInLoop(int fd, off_t offset, size_t count);
+    void spliceToInLoop(const TcpConnectionPtr& peer);
+    void handleSpliceRead();
+    void appendSpliced(const std::shared_ptr<PipePool::Pipe>& pipe, size_t len, const TcpConnectionPtr& source);
+    void onSpliceDrained();
+    MonoTime lastActivity(int type) const;
+    MonoTime idleDeadline(int type) const;
+    void armIdleTimer();
+    void handleIdleTimer();
 
     EventLoop* loop_;
     const std::string name_;
     std::atomic<StateE> state_;
-    bool reading_;
+    bool reading_;      // 用户是否希望读取，splice 转发因管道已满暂停读取时不改变它
 
     std::unique_ptr<Socket> socket_;
     std::unique_ptr<Channel> channel_;
@@ -73,9 +231,41 @@ private:
     CloseCallback closeCallback_;   // 连接关闭的回调函数，由TcpServer传入
     HighWaterMarkCallback highWaterMarkCallback_;   // 高水位回调函数，由TcpServer传入
     size_t highWaterMark_;
+    LowWaterMarkCallback lowWaterMarkCallback_;     // 低水位回调函数，与高水位回调成对使用
+    size_t lowWaterMark_;
+    bool aboveHighWater_;   // 已经触发高水位回调，还没有降到低水位
+
+    bool autoCork_;         // 是否合并同一轮事件循环中的多次 send
+    bool flushQueued_;      // 本轮是否已经排队了 flush
+    uint64_t numSendCalls_;
+    uint64_t numWriteSyscalls_;
+
+    std::atomic<size_t> zeroCopyThreshold_;
+    uint32_t zeroCopyNextSeq_;
+    std::deque<ZeroCopyInflight> zeroCopyInflight_;
+    bool zeroCopyLingering_;    // 正在轮询错误队列，等待剩余的完成通知
+    uint64_t numZeroCopySends_;
+    uint64_t numZeroCopyCompletions_;
+    uint64_t numZeroCopyCopied_;
 
     Buffer inputBuffer_;
-    Buffer outputBuffer_;
+    ChainBuffer outputBuffer_;  // 发送缓冲区由内存块串联而成，大数据量堆积时不需要扩容和搬移
+    std::deque<OutputEntry> outputQueue_;
+    size_t queuedBytes_;    // outputQueue_ 中各发送项未发送的字节数之和
+
+    std::shared_ptr<PipePool::Pipe> splicePipe_;    // 非空表示处于 splice 转发模式
+    std::weak_ptr<TcpConnection> spliceTarget_;
+    std::weak_ptr<TcpConnection> spliceSource_;    // 最近一个 splice 到本连接的来源，降到低水位时通知它恢复读取
+    bool splicePaused_;     // 管道已满或者 peer 在高水位之上，暂停读取
+    bool spliceReadEof_;    // 已经读到对端的 EOF
+
+    // 空闲检测都使用单调时钟，修改系统时间不会让所有连接同时超时，也不会让超时失效
+    int64_t idleTimeoutNs_[kNumIdleTypes];  // 各类空闲超时，0 表示不检测
+    MonoTime idleSince_[kNumIdleTypes];     // 上一次报告该类空闲的时间，之后要再空闲一个周期才会再次报告
+    MonoTime lastReadTime_;     // 热路径上只更新这两个时间戳
+    MonoTime lastWriteTime_;
+    TimerId idleTimer_;     // 无效表示没有定时
+    IdleCallback idleCallback_;
 };
 
 }
\ No newline at end of file
@@ -33,8 +33,17 @@ public:
     void setConnectionCallback(const ConnectionCallback& cb) { connectionCallback_ = cb; }
     void setMessageCallback(const MessageCallback& cb) { messageCallback_ = cb; }
     void setWriteCompleteCallback(const WriteCompleteCallback& cb) { writeCompleteCallback_ = cb; }
+    // 为之后建立的连接开启空闲检测，参数见 TcpConnection::setIdleTimeout，没有设置回调时空闲的连接被断开
+    void setIdleTimeout(double readerIdleSeconds, double writerIdleSeconds, double allIdleSeconds) {
+        readerIdleSeconds_ = readerIdleSeconds;
+        writerIdleSeconds_ = writerIdleSeconds;
+        allIdleSeconds_ = allIdleSeconds;
+    }
+    void setIdleCallback(const IdleCallback& cb) { idleCallback_ = cb; }
 
     void setThreadNum(int numThreads);
+    // 为所有 IO 线程开启忙轮询，需要在 start 之前调用，参数见 EventLoop::setBusyPoll
+    void setBusyPoll(double spinSeconds, int socketBusyPollUs = 0) { threadPool_->setBusyPoll(spinSeconds, socketBusyPollUs); }
 
     void start();
 
@@ -55,6 +64,10 @@ private:
     MessageCallback messageCallback_;
     WriteCompleteCallback writeCompleteCallback_;
     ThreadInitCallback threadInitCallback_;
+    IdleCallback idleCallback_;
+    double readerIdleSeconds_;
+    double writerIdleSeconds_;
+    double allIdleSeconds_;
 
     int numThreads_;    // 线程池中线程数
     std::atomic_int started_;
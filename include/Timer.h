@@ -1,7 +1,9 @@
+#pragma once
+
 #include <atomic>
 #include <functional>
 
-#include "TimeStamp.h"
+#include "MonoTime.h"
 #include "Callbacks.h"
 #include "copyable.h"
 
@@ -9,32 +11,49 @@ namespace muduo {
 
 class Timer : copyable {
 public:
-    Timer(TimerCallback cb, TimeStamp when, double interval) 
+    Timer(TimerCallback cb, MonoTime when, double interval)
+        : Timer(std::move(cb), when, interval, newSequence()) {}
+
+    // 序号由 newSequence() 预先分配，跨线程添加时 TimerId 可以在 Timer 创建之前返回
+    Timer(TimerCallback cb, MonoTime when, double interval, int64_t sequence)
         : callback_(std::move(cb)),
             expiration_(when),
             interval_(interval),
             repeat_(interval > 0.0),
-            sequence_(s_numCreated_.fetch_add(1)) 
+            sequence_(sequence),
+            prev_(nullptr),
+            next_(nullptr),
+            level_(-1),
+            slot_(-1)
         {}
 
     void run() const { callback_(); }
 
-    TimeStamp expiration() const { return expiration_; }
+    MonoTime expiration() const { return expiration_; }
     bool repeat() const { return repeat_; }
     int64_t sequence() const { return sequence_; }
 
-    void restart(TimeStamp now);
+    void restart(MonoTime now);
 
     static int64_t numCreated() { return s_numCreated_.load(); }
+    static int64_t newSequence() { return s_numCreated_.fetch_add(1); }
 
 private:
     const TimerCallback callback_;
-    TimeStamp expiration_;      // 下一次到期时间
+    MonoTime expiration_;       // 下一次到期时间
     const double interval_;     // 周期
     const bool repeat_;        // 是否重复
     const int64_t sequence_;    // 定时器序号
 
+    // 由 TimerWheel 维护：所在槽位的双向链表，以及层级和槽位下标
+    Timer* prev_;
+    Timer* next_;
+    int level_;
+    int slot_;
+
     static std::atomic<int64_t> s_numCreated_;
+
+    friend class TimerWheel;
 };
 
 }
\ No newline at end of file
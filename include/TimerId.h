@@ -1,21 +1,24 @@
 #pragma once
 
+#include <cstdint>
+
 #include "copyable.h"
-#include "Timer.h"
 
 namespace muduo {
 
+// 定时器的标识，只记录序号：Timer 对象由 TimerPool 复用，TimerQueue 按序号判断定时器是否仍然有效
 class TimerId : copyable {
 public:
-    TimerId() : timer_(nullptr), sequence_(0) {}
+    TimerId() : sequence_(-1) {}
+
+    explicit TimerId(int64_t seq) : sequence_(seq) {}
 
-    TimerId(Timer* timer, int64_t seq) : timer_(timer), sequence_(seq) {}
+    bool valid() const { return sequence_ >= 0; }
 
     friend class TimerQueue;
 
 private:
-    Timer* timer_;
     int64_t sequence_;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+#include "nocopyable.h"
+#include "Timer.h"
+
+namespace muduo {
+
+/**
+ * @brief Timer 对象池，每个 TimerQueue 持有一个
+ * @note 按块（每块 kTimersPerChunk 个）向全局分配器申请内存，释放的 Timer 放回空闲链表供下一次使用
+ * 每个请求都设置、取消一个超时定时器的场景下，稳定后添加/取消定时器不再调用全局分配器
+ * 只在 IO 线程中使用，不加锁；内存块只在析构时归还
+ */
+class TimerPool : nocopyable {
+public:
+    static const size_t kTimersPerChunk = 256;
+
+    TimerPool();
+    ~TimerPool();
+
+    Timer* create(TimerCallback cb, MonoTime when, double interval, int64_t sequence);
+    void destroy(Timer* timer);     // 析构 Timer（连同回调持有的对象）并放回空闲链表
+
+    size_t numInUse() const { return numInUse_; }
+    size_t numChunks() const { return chunks_.size(); }
+
+private:
+    union Slot {
+        Slot* next;     // 空闲时串成链表
+        typename std::aligned_storage<sizeof(Timer), alignof(Timer)>::type storage;
+    };
+
+    void grow();
+
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    Slot* freeList_;
+    size_t numInUse_;
+};
+
+}
@@ -1,7 +1,9 @@
 #pragma once
 
-#include <set>
-#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <atomic>
 
 #include "nocopyable.h"
 #include "TimerId.h"
@@ -9,43 +11,75 @@
 #include "Callbacks.h"
 #include "TimeStamp.h"
 #include "Channel.h"
+#include "TimerWheel.h"
+#include "TimerPool.h"
 
 namespace muduo {
 
 // 定时器队列类，负责管理定时器
 // 通过不断动态调整timerfd的到期时间，实现只用一个timerfd来管理所有定时器
+// 定时器存放在分层时间轮中，添加、取消和到期都是 O(1)，到期时间按 tick 向上取整
+// 到期时间使用单调时钟上的纳秒时间点，timerfd 按绝对时间设置，不受修改系统时间的影响
 class TimerQueue : nocopyable {
 public:
+    static const int64_t kDefaultTickNanoSeconds = 1000 * 1000;
+    // 下一次处理时间在这个范围之内时，支持纳秒精度等待的 Poller 直接等到该时间，不经过 timerfd
+    static const int64_t kShortWaitNanoSeconds = 1000 * 1000;
+
     explicit TimerQueue(EventLoop* loop);
     ~TimerQueue();
 
-    TimerId addTimer(TimerCallback cb, TimeStamp when, double interval);
+    TimerId addTimer(TimerCallback cb, MonoTime when, double interval);
 
     void cancel(TimerId timerId);
 
-private:
-    using Entry = std::pair<TimeStamp, Timer*>;
-    using TimerList = std::set<Entry>;
-    using ActiveTimer = std::pair<Timer*, int64_t>;
-    using ActiveTimerSet = std::set<ActiveTimer>;
+    // 调整时间轮的精度，已有的定时器按新精度重新插入，只能在 IO 线程中调用
+    void setResolution(double seconds);
+    double resolution() const;
+
+    /**
+     * 本轮循环中定时器的变化只记下需要重新计算下一次处理时间，由 EventLoop 在回到 poll 之前调用一次，
+     * 一轮中添加再多的定时器也最多调用一次 timerfd_settime，只能在 IO 线程中调用
+     * preciseWait 为 true 表示 Poller 的 pollNanos 支持纳秒精度：下一次处理时间在 kShortWaitNanoSeconds 之内时
+     * 不设置 timerfd，返回需要等待的纳秒数，由 poll 直接等到该时间，之后调用 expireTimers；否则返回 -1
+     */
+    int64_t prepareWait(MonoTime now, bool preciseWait);
+
+    // 处理到 now 为止已到期的定时器，只能在 IO 线程中调用
+    void expireTimers(MonoTime now);
 
+    // 统计，可以在任意线程读取：原来需要立即重新设置 timerfd 的次数，以及实际调用 timerfd_settime 的次数
+    uint64_t numRearmsRequested() const { return numRearmsRequested_.load(std::memory_order_relaxed); }
+    uint64_t numRearmsIssued() const { return numRearmsIssued_.load(std::memory_order_relaxed); }
+
+    size_t size() const { return activeTimers_.size(); }
+    const TimerPool& pool() const { return pool_; }
+
+private:
+    void createTimerInLoop(TimerCallback& cb, MonoTime when, double interval, int64_t sequence);
     void addTimerInLoop(Timer* timer);
     void cancelInLoop(TimerId timerId);
 
     void handleRead();
-    std::vector<Entry> getExpired(TimeStamp now);
-    void reset(const std::vector<Entry>& expired, TimeStamp now);
+    void reset(const std::vector<Timer*>& expired, MonoTime now);
 
-    bool insert(Timer* timer);
+    void insert(Timer* timer);
 
     EventLoop* loop_;
     const int timerfd_;
     Channel timerfdChannel_;
-    TimerList timers_;
+    TimerPool pool_;    // Timer 只在 IO 线程中创建和释放，都经过对象池
+    TimerWheel wheel_;
+    MonoTime armedExpiration_;      // timerfd 当前设置的到期时间，invalid 表示未设置
+    MonoTime nextExpiration_;       // 时间轮的下一次处理时间，nextDirty_ 为 true 时需要重新计算
+    bool nextDirty_;
+    std::atomic<uint64_t> numRearmsRequested_;
+    std::atomic<uint64_t> numRearmsIssued_;
 
-    ActiveTimerSet activeTimers_;
+    std::unordered_map<int64_t, Timer*> activeTimers_;  // key: 定时器序号，用于验证 TimerId 是否仍然有效
     bool callingExpiredTimers_;
-    ActiveTimerSet cancelingTimers_;
+    std::vector<Timer*> expired_;
+    std::unordered_set<int64_t> cancelingTimers_;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "nocopyable.h"
+#include "MonoTime.h"
+#include "Timer.h"
+
+namespace muduo {
+
+/**
+ * @brief 分层时间轮，TimerQueue 用它管理定时器
+ * @note 时间按固定的 tick 划分，第 0 层 256 个槽，每个槽对应一个 tick；往上五层各 64 个槽，每个槽覆盖下一层转一圈的时间
+ * 共 2^38 个 tick：默认 1ms 的 tick 可以覆盖数年，1us 的 tick 也能覆盖约 76 小时，秒级、分钟级的超时不会反复下移
+ * 插入时按距离到期的 tick 数选择层级，上层的槽在下层转完一圈时整体下移（重新插入），最终在第 0 层到期
+ * 插入、删除都是 O(1) 的链表操作，不分配内存；推进时直接跳到下一个非空槽（到期或下移），开销与经过的时间无关
+ * 超出最高层范围的定时器放在最高层最远的槽中，下移时按实际到期时间重新插入
+ * 到期时间向上取整到 tick，定时器不会提前触发，最多晚一个 tick
+ */
+class TimerWheel : nocopyable {
+public:
+    TimerWheel(int64_t tickNanoSeconds, MonoTime now);
+
+    void insert(Timer* timer);
+    void remove(Timer* timer);
+
+    // 推进到 now，按到期的 tick 先后把到期的定时器放入 expired
+    void advance(MonoTime now, std::vector<Timer*>* expired);
+
+    // 下一次需要处理的时间：最早的到期时间，或者更早的上层槽下移时间；没有定时器时返回 invalid
+    MonoTime nextExpiration() const;
+
+    // 取出所有定时器，用于析构
+    void takeAll(std::vector<Timer*>* timers);
+
+    // 调整 tick 的长度，已有的定时器按新的 tick 重新插入
+    void setTickNanoSeconds(int64_t tickNanoSeconds, MonoTime now);
+
+    size_t size() const { return size_; }
+    int64_t tickNanoSeconds() const { return tickNs_; }
+
+private:
+    static const int kNumLevels = 6;
+    static const int kLevel0Bits = 8;
+    static const int kLevelBits = 6;
+
+    static int levelShift(int level) { return level == 0 ? 0 : kLevel0Bits + (level - 1) * kLevelBits; }
+    static int levelSlots(int level) { return 1 << (level == 0 ? kLevel0Bits : kLevelBits); }
+
+    int64_t expirationTick(const Timer* timer) const;
+    // 按到期的 tick 选择层级和槽位，到期时间早于 minTick 的按 minTick 处理
+    void insertAt(Timer* timer, int64_t minTick);
+    void link(Timer* timer, int level, int slot);
+    void unlink(Timer* timer);
+    Timer* detachSlot(int level, int slot);
+    // 上层槽整体下移
+    void cascade(int level, int64_t tick);
+    // 下一个需要处理的 tick：第 0 层最早的到期 tick，或者更早的上层槽下移 tick；没有定时器时返回 INT64_MAX
+    int64_t nextEventTick() const;
+    // 从 from 开始循环查找第一个非空槽，返回相对 from 的偏移，全空返回 -1
+    int findOccupied(int level, int from) const;
+
+    int64_t tickNs_;
+    int64_t currentTick_;   // 已经处理到的 tick
+    size_t size_;
+    std::vector<Timer*> slots_[kNumLevels];
+    uint64_t occupied_[kNumLevels][4];  // 每层非空槽的位图，第 0 层 256 位，其他层 64 位
+};
+
+}
@@ -1,4 +1,4 @@
-#include <sys/uio.h>    
+#include <sys/uio.h>
 #include <errno.h>
 #include <unistd.h>
 
@@ -6,15 +6,27 @@
 
 namespace muduo {
 
+const size_t Buffer::kCheapPrepend;
+const size_t Buffer::kInitialSize;
+const size_t Buffer::kMaxReadSizeHint;
+
+std::atomic<uint64_t> Buffer::s_totalOverflowReads_(0);
+std::atomic<uint64_t> Buffer::s_totalOverflowBytes_(0);
+
 /*
     Poller 是 LT 模式，所以需要一次性将数据读完
     buffer 有大小，但是tcp 传输的数据大小是不确定的，所以需要用到额外的空间
     1. 如果预留空间足够大，可以直接使用
     2. 如果预留空间不够大，则使用额外的空间
+
+    读之前先按 readSizeHint_ 预留好可写空间，大多数情况下数据会直接读进 buffer_
+    只有突发的大数据量才会溢出到 extrabuf，此时需要再 append 拷贝一次，同时放大 readSizeHint_
 */
 ssize_t Buffer::readFd(int fd, int *saveErrno) {
     char extrabuf[65536];   // 64KB 额外空间
 
+    ensureWritableBytes(readSizeHint_);
+
     /*
         scatter/gather I/O
         分散读取，集中写入
@@ -42,13 +54,41 @@ ssize_t Buffer::readFd(int fd, int *saveErrno) {
     } else if (static_cast<size_t>(n) <= writable) {    // 只使用到了 buffer_ 的空间
         writerIndex_ += n;
     } else {    // 使用了额外的空间
+        ++numOverflowReads_;
+        s_totalOverflowReads_.fetch_add(1, std::memory_order_relaxed);
+        s_totalOverflowBytes_.fetch_add(n - writable, std::memory_order_relaxed);
         writerIndex_ = buffer_.size();
         append(extrabuf, n - writable);
     }
 
+    if (n > 0) {
+        ++numReads_;
+        adjustReadSizeHint(static_cast<size_t>(n), writable);
+    }
+
     return n;
 }
 
+/*
+    根据本次读到的数据量调整下一次预留的可写空间
+    1. 可写空间被读满（或溢出），说明对端数据量大，预留空间翻倍
+    2. 连续多次只用到不到 1/4，说明流量已经变小，预留空间减半
+*/
+void Buffer::adjustReadSizeHint(size_t n, size_t writable) {
+    if (n >= writable) {
+        smallReads_ = 0;
+        size_t hint = std::max(readSizeHint_ * 2, n);
+        readSizeHint_ = std::min(hint, kMaxReadSizeHint);
+    } else if (n < readSizeHint_ / 4) {
+        if (++smallReads_ >= kShrinkAfterSmallReads) {
+            smallReads_ = 0;
+            readSizeHint_ = std::max(readSizeHint_ / 2, kInitialSize);
+        }
+    } else {
+        smallReads_ = 0;
+    }
+}
+
 ssize_t Buffer::writeFd(int fd, int *saveErrno) {
     ssize_t n = ::write(fd, peek(), readableBytes());
 
@@ -59,4 +99,4 @@ ssize_t Buffer::writeFd(int fd, int *saveErrno) {
     return n;
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,93 @@
+#include "BufferPool.h"
+
+namespace muduo {
+
+std::atomic<size_t> BufferPool::s_globalMaxBytes_(0);
+std::atomic<size_t> BufferPool::s_globalBytesInUse_(0);
+
+BufferPool::BufferPool(size_t blockSize, size_t maxFreeBlocks)
+    : blockSize_(blockSize),
+      maxFreeBlocks_(maxFreeBlocks),
+      maxBytes_(0),
+      minFreeSinceTrim_(0),
+      bytesInUse_(0),
+      peakBytesInUse_(0),
+      bytesCached_(0),
+      numAllocFailures_(0) {
+    freeBlocks_.reserve(maxFreeBlocks_);
+}
+
+BufferPool::~BufferPool() {
+    for (char* block : freeBlocks_) {
+        delete[] block;
+    }
+}
+
+char* BufferPool::allocate() {
+    // 先占用额度再检查，并发的分配不会同时通过检查而超出上限；超出时退回占用的额度
+    size_t maxBytes = maxBytes_;
+    size_t inUse = bytesInUse_.fetch_add(blockSize_) + blockSize_;
+    if (maxBytes > 0 && inUse > maxBytes) {
+        bytesInUse_ -= blockSize_;
+        ++numAllocFailures_;
+        return nullptr;
+    }
+    size_t globalMaxBytes = s_globalMaxBytes_;
+    size_t globalInUse = s_globalBytesInUse_.fetch_add(blockSize_) + blockSize_;
+    if (globalMaxBytes > 0 && globalInUse > globalMaxBytes) {
+        s_globalBytesInUse_ -= blockSize_;
+        bytesInUse_ -= blockSize_;
+        ++numAllocFailures_;
+        return nullptr;
+    }
+
+    size_t peak = peakBytesInUse_;
+    while (inUse > peak && !peakBytesInUse_.compare_exchange_weak(peak, inUse)) {
+    }
+
+    char* block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!freeBlocks_.empty()) {
+            block = freeBlocks_.back();
+            freeBlocks_.pop_back();
+            bytesCached_ -= blockSize_;
+            if (freeBlocks_.size() < minFreeSinceTrim_) {
+                minFreeSinceTrim_ = freeBlocks_.size();
+            }
+        }
+    }
+
+    return block ? block : new char[blockSize_];
+}
+
+void BufferPool::deallocate(char* block) {
+    s_globalBytesInUse_ -= blockSize_;
+    bytesInUse_ -= blockSize_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (freeBlocks_.size() < maxFreeBlocks_) {
+            freeBlocks_.push_back(block);
+            bytesCached_ += blockSize_;
+            return;
+        }
+    }
+    delete[] block;     // 缓存已满，直接释放
+}
+
+void BufferPool::trim() {
+    std::vector<char*> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t n = minFreeSinceTrim_;
+        idle.assign(freeBlocks_.begin(), freeBlocks_.begin() + n);  // 栈底的内存块最久没被用到
+        freeBlocks_.erase(freeBlocks_.begin(), freeBlocks_.begin() + n);
+        bytesCached_ -= n * blockSize_;
+        minFreeSinceTrim_ = freeBlocks_.size();
+    }
+    for (char* block : idle) {
+        delete[] block;
+    }
+}
+
+}
@@ -0,0 +1,214 @@
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MUDUO_SCAN_X86 1
+#endif
+
+#include "ByteScanner.h"
+
+namespace muduo {
+
+namespace {
+
+// 标量实现，作为非 x86 平台以及 SIMD 实现处理尾部数据时的兜底
+
+// 单字节查找直接使用 libc 的 memchr：glibc 已经在运行时为其选择了 SSE2/AVX2/EVEX 实现并做了循环展开，
+// 实测比单路展开的 intrinsics 版本更快，所以各个指令集级别都复用它
+const char* scalarFindByte(const char* begin, const char* end, char c) {
+    return static_cast<const char*>(::memchr(begin, c, end - begin));
+}
+
+const char* scalarFindCRLF(const char* begin, const char* end) {
+    const char* p = begin;
+    while (end - p >= 2) {
+        p = static_cast<const char*>(::memchr(p, '\r', end - p - 1));
+        if (p == nullptr) {
+            return nullptr;
+        }
+        if (p[1] == '\n') {
+            return p;
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+const char* scalarFindAnyOf(const char* begin, const char* end, const char* set, size_t setLen) {
+    bool table[256] = {false};
+    for (size_t i = 0; i < setLen; ++i) {
+        table[static_cast<unsigned char>(set[i])] = true;
+    }
+    for (const char* p = begin; p < end; ++p) {
+        if (table[static_cast<unsigned char>(*p)]) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+#ifdef MUDUO_SCAN_X86
+
+const size_t kMaxSimdSetSize = 16;     // 字节集合超过这个大小时逐个比较不划算，退回查表
+
+// SSE2 是 x86_64 的基础指令集，不需要额外的编译选项
+
+// 同时比较 p 处的 '\r' 和 p + 1 处的 '\n'，两个掩码相与即为 CRLF 的起始位置
+const char* sse2FindCRLF(const char* begin, const char* end) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const char* p = begin;
+    while (end - p >= 17) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, cr), _mm_cmpeq_epi8(second, lf))));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return scalarFindCRLF(p, end);
+}
+
+const char* sse2FindAnyOf(const char* begin, const char* end, const char* set, size_t setLen) {
+    if (setLen == 0) {
+        return nullptr;
+    }
+    if (setLen > kMaxSimdSetSize) {
+        return scalarFindAnyOf(begin, end, set, setLen);
+    }
+
+    __m128i needles[kMaxSimdSetSize];
+    for (size_t i = 0; i < setLen; ++i) {
+        needles[i] = _mm_set1_epi8(set[i]);
+    }
+    const char* p = begin;
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hit = _mm_cmpeq_epi8(chunk, needles[0]);
+        for (size_t i = 1; i < setLen; ++i) {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, needles[i]));
+        }
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return scalarFindAnyOf(p, end, set, setLen);
+}
+
+// AVX2 实现只对这几个函数开启 avx2 指令，由运行时检测决定是否调用
+// 每轮处理 64 字节，两路比较结果合并后再判断，减少分支
+
+__attribute__((target("avx2")))
+const char* avx2FindCRLF(const char* begin, const char* end) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const char* p = begin;
+    while (end - p >= 65) {
+        __m256i hit0 = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), cr),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1)), lf));
+        __m256i hit1 = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), cr),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 33)), lf));
+        if (_mm256_movemask_epi8(_mm256_or_si256(hit0, hit1)) != 0) {
+            unsigned mask0 = static_cast<unsigned>(_mm256_movemask_epi8(hit0));
+            if (mask0 != 0) {
+                return p + __builtin_ctz(mask0);
+            }
+            return p + 32 + __builtin_ctz(static_cast<unsigned>(_mm256_movemask_epi8(hit1)));
+        }
+        p += 64;
+    }
+    return sse2FindCRLF(p, end);
+}
+
+__attribute__((target("avx2")))
+const char* avx2FindAnyOf(const char* begin, const char* end, const char* set, size_t setLen) {
+    if (setLen == 0) {
+        return nullptr;
+    }
+    if (setLen > kMaxSimdSetSize) {
+        return scalarFindAnyOf(begin, end, set, setLen);
+    }
+
+    __m256i needles[kMaxSimdSetSize];
+    for (size_t i = 0; i < setLen; ++i) {
+        needles[i] = _mm256_set1_epi8(set[i]);
+    }
+    const char* p = begin;
+    while (end - p >= 64) {
+        __m256i chunk0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i chunk1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+        __m256i hit0 = _mm256_cmpeq_epi8(chunk0, needles[0]);
+        __m256i hit1 = _mm256_cmpeq_epi8(chunk1, needles[0]);
+        for (size_t i = 1; i < setLen; ++i) {
+            hit0 = _mm256_or_si256(hit0, _mm256_cmpeq_epi8(chunk0, needles[i]));
+            hit1 = _mm256_or_si256(hit1, _mm256_cmpeq_epi8(chunk1, needles[i]));
+        }
+        if (_mm256_movemask_epi8(_mm256_or_si256(hit0, hit1)) != 0) {
+            unsigned mask0 = static_cast<unsigned>(_mm256_movemask_epi8(hit0));
+            if (mask0 != 0) {
+                return p + __builtin_ctz(mask0);
+            }
+            return p + 32 + __builtin_ctz(static_cast<unsigned>(_mm256_movemask_epi8(hit1)));
+        }
+        p += 64;
+    }
+    return sse2FindAnyOf(p, end, set, setLen);
+}
+
+bool cpuSupportsAVX2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+const ByteScanner kScalarScanner = {
+    scalarFindByte, scalarFindAnyOf, scalarFindCRLF, ByteScanner::kScalar, "scalar"
+};
+
+#ifdef MUDUO_SCAN_X86
+const ByteScanner kSSE2Scanner = {
+    scalarFindByte, sse2FindAnyOf, sse2FindCRLF, ByteScanner::kSSE2, "sse2"
+};
+
+const ByteScanner kAVX2Scanner = {
+    scalarFindByte, avx2FindAnyOf, avx2FindCRLF, ByteScanner::kAVX2, "avx2"
+};
+#endif
+
+}   // namespace
+
+const ByteScanner* ByteScanner::get(Level level) {
+    switch (level) {
+    case kScalar:
+        return &kScalarScanner;
+#ifdef MUDUO_SCAN_X86
+    case kSSE2:
+        return &kSSE2Scanner;
+    case kAVX2:
+        return cpuSupportsAVX2() ? &kAVX2Scanner : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const ByteScanner& ByteScanner::best() {
+    static const ByteScanner* scanner = []() {
+        const ByteScanner* s = get(kAVX2);
+        if (s == nullptr) {
+            s = get(kSSE2);
+        }
+        return s ? s : get(kScalar);
+    }();
+    return *scanner;
+}
+
+}
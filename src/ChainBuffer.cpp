@@ -0,0 +1,169 @@
+#include <sys/uio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <cstring>
+#include <algorithm>
+
+#include "ChainBuffer.h"
+
+namespace muduo {
+
+ChainBuffer::ChainBuffer(std::shared_ptr<BufferPool> pool)
+    : pool_(pool ? std::move(pool) : std::make_shared<BufferPool>()),
+      blockSize_(pool_->blockSize()),
+      readableBytes_(0),
+      totalAppended_(0),
+      totalRetrieved_(0) {}
+
+ChainBuffer::~ChainBuffer() {
+    for (const Block& block : blocks_) {
+        pool_->deallocate(block.data);
+    }
+}
+
+// 丢弃头部内存块，归还给内存池
+void ChainBuffer::popFront() {
+    pool_->deallocate(blocks_.front().data);
+    blocks_.pop_front();
+}
+
+void ChainBuffer::retrieve(size_t len) {
+    len = std::min(len, readableBytes_);
+    totalRetrieved_ += len;
+    while (len > 0) {
+        Block& front = blocks_.front();
+        size_t readable = front.readableBytes();
+        if (len < readable) {
+            front.readIndex += len;
+            readableBytes_ -= len;
+            break;
+        }
+        len -= readable;
+        readableBytes_ -= readable;
+        popFront();
+    }
+}
+
+void ChainBuffer::retrieveAll() {
+    retrieve(readableBytes_);
+}
+
+std::string ChainBuffer::retrieveAsString(size_t len) {
+    len = std::min(len, readableBytes_);
+    std::string str;
+    str.reserve(len);
+    size_t copied = 0;
+    for (const Block& block : blocks_) {
+        if (copied == len) {
+            break;
+        }
+        size_t n = std::min(block.readableBytes(), len - copied);
+        str.append(block.data + block.readIndex, n);
+        copied += n;
+    }
+    retrieve(len);
+    return str;
+}
+
+bool ChainBuffer::append(const char *data, size_t len) {
+    // 先申请好所需的全部内存块，保证要么全部追加，要么什么都不追加
+    const size_t writable = writableBytes();
+    const size_t oldBlocks = blocks_.size();
+    if (len > writable) {
+        size_t needed = (len - writable + blockSize_ - 1) / blockSize_;
+        for (size_t i = 0; i < needed; ++i) {
+            char* block = pool_->allocate();
+            if (block == nullptr) {
+                while (blocks_.size() > oldBlocks) {
+                    pool_->deallocate(blocks_.back().data);
+                    blocks_.pop_back();
+                }
+                return false;
+            }
+            blocks_.push_back(Block{block, 0, 0});
+        }
+    }
+
+    totalAppended_ += len;
+    // 从原来尾部内存块的剩余空间开始写
+    size_t index = writable > 0 ? oldBlocks - 1 : oldBlocks;
+    while (len > 0) {
+        Block& tail = blocks_[index++];
+        size_t n = std::min(len, blockSize_ - tail.writeIndex);
+        ::memcpy(tail.data + tail.writeIndex, data, n);
+        tail.writeIndex += n;
+        readableBytes_ += n;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+/*
+    与 Buffer::readFd 一样，尾部内存块的剩余空间加上栈上的额外空间作为 readv 的目标
+    溢出到栈上的数据再 append 进来，只按实际读到的字节数向内存池申请内存块，小的读取不会临时占用多个内存块
+*/
+ssize_t ChainBuffer::readFd(int fd, int *savedErrno) {
+    char extrabuf[65536];   // 64KB 额外空间
+
+    struct iovec vec[2];
+    int iovcnt = 0;
+    const size_t writable = writableBytes();
+    if (writable > 0) {
+        Block& tail = blocks_.back();
+        vec[iovcnt].iov_base = tail.data + tail.writeIndex;
+        vec[iovcnt].iov_len = writable;
+        ++iovcnt;
+    }
+    vec[iovcnt].iov_base = extrabuf;
+    vec[iovcnt].iov_len = sizeof(extrabuf);
+    ++iovcnt;
+
+    const ssize_t n = ::readv(fd, vec, iovcnt);
+    if (n < 0) {
+        *savedErrno = errno;
+        return n;
+    }
+
+    size_t used = std::min(static_cast<size_t>(n), writable);
+    if (used > 0) {
+        blocks_.back().writeIndex += used;
+        readableBytes_ += used;
+        totalAppended_ += used;
+    }
+    // 内存池达到上限时溢出的数据无处存放，按出错处理，由调用者关闭连接
+    if (static_cast<size_t>(n) > used && !append(extrabuf, n - used)) {
+        *savedErrno = ENOBUFS;
+        return -1;
+    }
+
+    return n;
+}
+
+// 将链上的多个内存块通过 writev 一次性写出
+ssize_t ChainBuffer::writeFd(int fd, int *savedErrno, size_t maxBytes) {
+    struct iovec vec[kMaxWriteIovecs];
+    int iovcnt = 0;
+    for (const Block& block : blocks_) {
+        if (iovcnt == kMaxWriteIovecs || maxBytes == 0) {
+            break;
+        }
+        if (block.readableBytes() == 0) {
+            continue;
+        }
+        size_t len = std::min(block.readableBytes(), maxBytes);
+        vec[iovcnt].iov_base = block.data + block.readIndex;
+        vec[iovcnt].iov_len = len;
+        maxBytes -= len;
+        ++iovcnt;
+    }
+
+    ssize_t n = ::writev(fd, vec, iovcnt);
+    if (n < 0) {
+        *savedErrno = errno;
+    }
+
+    return n;
+}
+
+}
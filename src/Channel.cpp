@@ -69,8 +69,10 @@ void Channel::handleEventWithGuard(TimeStamp receiveTime) {
         if (closeCallback_) closeCallback_();
     }
 
+    // 错误队列非空时 epoll 同样会报告 EPOLLERR，先交给 errorQueueCallback_ 取走通知，确实出错时才调用 errorCallback_
     if (revents_ & EPOLLERR) {
-        if (errorCallback_) errorCallback_();
+        bool onlyNotifications = errorQueueCallback_ && errorQueueCallback_();
+        if (!onlyNotifications && errorCallback_) errorCallback_();
     }
 
     if (revents_ & (EPOLLIN | EPOLLPRI)) {
@@ -1,16 +1,28 @@
 #include <cstdlib>
+#include <errno.h>
 
 #include "Poller.h"
 #include "EpollPoller.h"
+#include "IoUringPoller.h"
+#include "Logger.h"
 
 namespace muduo {
 
 Poller* Poller::newDefaultPoller(EventLoop* loop) {
     if (::getenv("MUDUO_USE_POLL")) {
         return nullptr;
+    } else if (::getenv("MUDUO_USE_IO_URING")) {
+        IoUringPoller* poller = new IoUringPoller(loop);
+        if (poller->valid()) {
+            return poller;
+        }
+        int savedErrno = errno;
+        delete poller;
+        LOG_ERROR("Poller::newDefaultPoller - io_uring unavailable: %d, falling back to epoll", savedErrno);
+        return new EpollPoller(loop);
     } else {
         return new EpollPoller(loop);
     }
 }
 
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #include <unistd.h>
 #include <errno.h>
 #include <cstring>
+#include <time.h>
+#include <sys/syscall.h>
 
 #include "EpollPoller.h"
 #include "Channel.h"
@@ -21,13 +23,27 @@ const int kNew = -1;        // 新 Channel，没有添加到 epoll 中
 const int kAdded = 1;       // 已经添加到 epoll 中
 const int kDeleted = 2;     // 暂时不用，还在 channels_ 中
 
+// 直接使用系统调用，不依赖 glibc 2.35 才提供的封装；编译环境没有该系统调用号时返回 ENOSYS
+int epollPwait2(int epfd, struct epoll_event* events, int maxevents, const struct timespec* timeout) {
+#ifdef SYS_epoll_pwait2
+    return static_cast<int>(::syscall(SYS_epoll_pwait2, epfd, events, maxevents, timeout, nullptr, 0));
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
 EpollPoller::EpollPoller(EventLoop* loop)
     : Poller(loop),
       epollfd_(::epoll_create1(EPOLL_CLOEXEC)),
-      events_(kInitEventListSize) {
+      events_(kInitEventListSize),
+      hasPwait2_(false) {
     if (epollfd_ < 0) {
         LOG_FATAL("EpollPoller::EpollPoller - epoll_create1() error: %d", errno);
     }
+    // 还没有任何 fd，0 超时的调用立即返回，只用来探测内核是否支持
+    struct timespec zero = {0, 0};
+    hasPwait2_ = epollPwait2(epollfd_, &*events_.begin(), static_cast<int>(events_.size()), &zero) >= 0;
 }
 
 EpollPoller::~EpollPoller() {
@@ -38,8 +54,25 @@ TimeStamp EpollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
     LOG_DEBUG("func = %s => fd total count %lu", __FUNCTION__, channels_.size());
 
     // 调用 epoll_wait() 获取发生的事件
+    numSyscalls_.fetch_add(1, std::memory_order_relaxed);
     int numEvents = ::epoll_wait(epollfd_, &*events_.begin(), static_cast<int>(events_.size()), timeoutMs);
-    int savedErrno = errno;
+    return handleEvents(numEvents, errno, activeChannels);
+}
+
+// epoll_wait() 的超时只精确到毫秒，即将到期的定时器改用 epoll_pwait2() 按纳秒等待
+TimeStamp EpollPoller::pollNanos(int64_t timeoutNs, ChannelList* activeChannels) {
+    if (!hasPwait2_) {
+        return Poller::pollNanos(timeoutNs, activeChannels);
+    }
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeoutNs / (1000 * 1000 * 1000));
+    ts.tv_nsec = static_cast<long>(timeoutNs % (1000 * 1000 * 1000));
+    numSyscalls_.fetch_add(1, std::memory_order_relaxed);
+    int numEvents = epollPwait2(epollfd_, &*events_.begin(), static_cast<int>(events_.size()), &ts);
+    return handleEvents(numEvents, errno, activeChannels);
+}
+
+TimeStamp EpollPoller::handleEvents(int numEvents, int savedErrno, ChannelList* activeChannels) {
     TimeStamp now(TimeStamp::now());
 
     if (numEvents > 0) {
@@ -126,6 +159,7 @@ void EpollPoller::update(int operation, Channel *channel) {
     ev.data.fd = fd;
     ev.data.ptr = channel;
 
+    numSyscalls_.fetch_add(1, std::memory_order_relaxed);
     if (::epoll_ctl(epollfd_, operation, fd, &ev) < 0) {
         if (operation == EPOLL_CTL_DEL) {
             LOG_ERROR("EpollPoller::update() - epoll_ctl() del error: %d", errno);
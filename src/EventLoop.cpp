@@ -1,8 +1,10 @@
 #include <sys/eventfd.h>
+#include <sys/prctl.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <error.h>
 #include <memory>
+#include <chrono>
 
 #include "EventLoop.h"
 #include "Channel.h"
@@ -19,6 +21,9 @@ thread_local EventLoop* t_loopInThisThread = nullptr;
 // IO复用接口超时时间
 const int kPollTimeMs = 10000;
 
+// 内存池回收空闲内存块的周期（单位：秒）
+const double kBufferPoolTrimInterval = 10.0;
+
 // 创建一个eventfd用于唤醒IO线程
 int createEventfd() {
     int evtfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
@@ -35,7 +40,25 @@ EventLoop::EventLoop()
         poller_(Poller::newDefaultPoller(this)),
         wakeupFd_(createEventfd()),
         wakeupChannel_(new Channel(this, wakeupFd_)),
-        timerQueue_(new TimerQueue(this)) {
+        wakeupPending_(false),
+        numWakeupsRequested_(0),
+        numWakeupsIssued_(0),
+        timerQueue_(new TimerQueue(this)),
+        bufferPool_(std::make_shared<BufferPool>()),
+        pipePool_(std::make_shared<PipePool>()),
+        callingPendingFunctors_(false),
+        maxFunctorsPerIteration_(0),
+        maxFunctorSecondsPerIteration_(0.0),
+        numFunctorBudgetExhausted_(0),
+        busyPollNanos_(0),
+        socketBusyPollUs_(0),
+        numSpinPolls_(0),
+        numBlockingPolls_(0),
+        numDeferredPolls_(0),
+        spinNanos_(0),
+        blockNanos_(0),
+        preciseTimerWait_(false),
+        savedTimerSlack_(0) {
     
     LOG_DEBUG("EventLoop created %p in thread %d", this, threadId_);
     if (t_loopInThisThread) {
@@ -52,30 +75,82 @@ EventLoop::~EventLoop() {
     wakeupChannel_->disableAll();
     wakeupChannel_->remove();
     ::close(wakeupFd_);
+    // timer slack 属于 IO 线程，只有在 IO 线程中析构时才需要恢复
+    if (preciseTimerWait_ && isInLoopThread()) {
+        setPreciseTimerWait(false);
+    }
     t_loopInThisThread = nullptr;
 }
 
 void EventLoop::loop() {
     looping_ = true;
     quit_ = false;
+    lastTrimTime_ = TimeStamp::now();
 
     LOG_DEBUG("EventLoop %p start looping", this);
 
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point lastActive = Clock::now();
     while (!quit_) {
         activeChannels_.clear();
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        // 上一轮超出预算留下的任务不能等到下一次唤醒，只检查一下 IO 事件就继续执行
+        // 开启忙轮询时，最近一次活动之后的窗口内同样用 0 超时，不进入睡眠
+        Clock::time_point start = Clock::now();
+        bool deferred = !pendingFunctors_.empty();
+        bool busySpin = !deferred && busyPollNanos_ > 0 &&
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(start - lastActive).count() < busyPollNanos_;
+        bool spin = deferred || busySpin;
+        // 本轮定时器的变化合并为一次 timerfd_settime；下一个定时器很近时由 poll 直接等到它的到期时间
+        MonoTime monoStart(std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count());
+        int64_t timerWaitNs = timerQueue_->prepareWait(monoStart, preciseTimerWait_ && poller_->hasNanosecondTimeout());
+        // 次数在进入前统计，正在阻塞中的这一次也能被其他线程看到；耗时在返回后统计
+        // 为剩余任务做的 0 超时轮询单独计数，忙轮询的统计只反映忙轮询窗口
+        if (deferred) {
+            numDeferredPolls_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            (busySpin ? numSpinPolls_ : numBlockingPolls_).fetch_add(1, std::memory_order_relaxed);
+        }
+        if (timerWaitNs >= 0) {
+            pollReturnTime_ = poller_->pollNanos(spin ? 0 : timerWaitNs, &activeChannels_);
+        } else {
+            pollReturnTime_ = poller_->poll(spin ? 0 : kPollTimeMs, &activeChannels_);
+        }
+        Clock::time_point end = Clock::now();
+        pollReturnMonoTime_ = MonoTime(std::chrono::duration_cast<std::chrono::nanoseconds>(end.time_since_epoch()).count());
+        int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        if (!deferred) {
+            (busySpin ? spinNanos_ : blockNanos_).fetch_add(elapsed, std::memory_order_relaxed);
+        }
+        if (!activeChannels_.empty()) {
+            lastActive = end;
+        }
         for (Channel* channel : activeChannels_) {
             // Poller 监听到的事件发生，调用Channel的handleEvent函数处理相应事件
             channel->handleEvent(pollReturnTime_);
         }
+        if (timerWaitNs >= 0) {
+            timerQueue_->expireTimers(pollReturnMonoTime_);
+        }
         // 执行当前EventLoop中的等待执行的回调任务
         doPendingFunctors();
+
+        // 周期性释放内存池中一个周期内都没被用到的空闲内存块
+        if (timeDifference(pollReturnTime_, lastTrimTime_) >= kBufferPoolTrimInterval) {
+            bufferPool_->trim();
+            lastTrimTime_ = pollReturnTime_;
+        }
     }
 
     LOG_DEBUG("EventLoop %p stop looping", this);
+    poller_->stopPolling();
     looping_ = false;
 }
 
+void EventLoop::setBusyPoll(double spinSeconds, int socketBusyPollUs) {
+    busyPollNanos_ = spinSeconds > 0.0 ? static_cast<int64_t>(spinSeconds * 1e9) : 0;
+    socketBusyPollUs_ = socketBusyPollUs > 0 ? socketBusyPollUs : 0;
+}
+
 void EventLoop::quit() {
     quit_ = true;
     if (!isInLoopThread()) {
@@ -87,8 +162,15 @@ void EventLoop::quit() {
  * 通过 eventfd 结合 epoll 实现跨线程唤醒（wakeup）
  * eventfd 本质上是一个计数器，可以通过 write 向其写入一个 8 字节的数据，这样 epoll 就会监听到 wakeupChannel_ 的读事件
  * 从而唤醒 IO 线程来执行相应的任务
+ * 唤醒合并：wakeupPending_ 为 true 时 IO 线程一定还会再执行一次 doPendingFunctors，不需要再写一次 eventfd
+ * 大量工作线程向同一个 IO 线程投递任务时，一批任务只产生一次 write 系统调用
  */
 void EventLoop::wakeup() {
+    numWakeupsRequested_.fetch_add(1, std::memory_order_relaxed);
+    if (wakeupPending_.exchange(true)) {
+        return;
+    }
+    numWakeupsIssued_.fetch_add(1, std::memory_order_relaxed);
     uint64_t one = 1;
     ssize_t n = ::write(wakeupFd_, &one, sizeof(one));
     if (n != sizeof(one)) {
@@ -120,11 +202,15 @@ void EventLoop::runInLoop(Functor cb) {
     }
 }
 
-void EventLoop::queueInLoop(Functor cb) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        pendingFunctors_.push_back(std::move(cb));
+void EventLoop::queueUrgentInLoop(Functor cb) {
+    urgentFunctors_.push(std::move(cb));
+    if (!isInLoopThread() || callingPendingFunctors_) {
+        wakeup();
     }
+}
+
+void EventLoop::queueInLoop(Functor cb) {
+    pendingFunctors_.push(std::move(cb));
 
     /**
      * 如果不是当前IO线程调用queueInLoop，或者当前IO线程正在执行pendingFunctors_中的任务，则唤醒IO线程执行cb
@@ -149,17 +235,41 @@ bool EventLoop::hasChannel(Channel* channel) {
 }
 
 void EventLoop::doPendingFunctors() {
-    std::vector<Functor> functors;
     callingPendingFunctors_ = true;
 
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        functors.swap(pendingFunctors_);    // 交换pendingFunctors_和functors，减小临界区长度
-        // 交换后pendingFunctors_为空，不会阻塞其他线程往pendingFunctors_中添加任务
-    }
+    /**
+     * 先清除 wakeupPending_ 再取任务：在此之后放入的任务会重新写 eventfd，不会漏掉
+     * 在此之前放入而跳过写 eventfd 的任务，exchange 读到了它们写入的 true，保证能看到它们已经放入队列的节点
+     */
+    wakeupPending_.exchange(false);
+
+    urgentFunctors_.consumeAll([](Functor& functor) {
+        functor();
+    });
 
-    for (const Functor& functor : functors) {
-        functor();  // 执行回调
+    // 一次取走当前的全部任务，执行期间新加入的任务留到下一轮，不会阻塞其他线程继续放入
+    // 设置了预算时执行到预算用完为止，剩下的留在队列中，下一轮先处理 IO 事件
+    const size_t maxTasks = maxFunctorsPerIteration_;
+    const double maxSeconds = maxFunctorSecondsPerIteration_;
+    if (maxTasks == 0 && maxSeconds <= 0.0) {
+        pendingFunctors_.consumeAll([](Functor& functor) {
+            functor();  // 执行回调
+        });
+    } else {
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point deadline = Clock::now() +
+            std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(maxSeconds));
+        size_t count = 0;
+        bool exhausted = false;
+        pendingFunctors_.consumeWhile([&](Functor& functor) {
+            functor();
+            ++count;
+            exhausted = (maxTasks > 0 && count >= maxTasks) || (maxSeconds > 0.0 && Clock::now() >= deadline);
+            return !exhausted;
+        });
+        if (exhausted && !pendingFunctors_.empty()) {
+            ++numFunctorBudgetExhausted_;
+        }
     }
 
     callingPendingFunctors_ = false;
@@ -169,19 +279,52 @@ void EventLoop::doPendingFunctors() {
 
 // 在 time 时间点执行 cb
 TimerId EventLoop::runAt(TimeStamp time, Functor cb) {
+    return timerQueue_->addTimer(std::move(cb), MonoTime::fromTimeStamp(time), 0.0);
+}
+
+TimerId EventLoop::runAt(MonoTime time, Functor cb) {
     return timerQueue_->addTimer(std::move(cb), time, 0.0);
 }
 
 // 在 delay 时间后执行 cb（单位：秒）
 TimerId EventLoop::runAfter(double delay, Functor cb) {
-    TimeStamp time(addTime(TimeStamp::now(), delay));
-    return runAt(time, std::move(cb));
+    return runAt(addTime(MonoTime::now(), delay), std::move(cb));
 }
 
 // 每隔 interval 时间执行 cb（单位：秒）
 TimerId EventLoop::runEvery(double interval, Functor cb) {
-    TimeStamp time(addTime(TimeStamp::now(), interval));
-    return timerQueue_->addTimer(std::move(cb), time, interval);
+    return timerQueue_->addTimer(std::move(cb), addTime(MonoTime::now(), interval), interval);
+}
+
+void EventLoop::setPreciseTimerWait(bool on) {
+    assertInLoopThread();
+    if (on == preciseTimerWait_) {
+        return;
+    }
+    preciseTimerWait_ = on;
+    // timer slack 是线程的属性，开启时记下原来的值，关闭时原样恢复
+    if (on) {
+        savedTimerSlack_ = ::prctl(PR_GET_TIMERSLACK);
+        ::prctl(PR_SET_TIMERSLACK, 1UL);
+    } else if (savedTimerSlack_ > 0) {
+        ::prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(savedTimerSlack_));
+    }
+}
+
+uint64_t EventLoop::numTimerRearmsRequested() const {
+    return timerQueue_->numRearmsRequested();
+}
+
+uint64_t EventLoop::numTimerRearmsIssued() const {
+    return timerQueue_->numRearmsIssued();
+}
+
+void EventLoop::cancel(TimerId timerId) {
+    timerQueue_->cancel(timerId);
+}
+
+void EventLoop::setTimerResolution(double seconds) {
+    runInLoop([this, seconds]() { timerQueue_->setResolution(seconds); });
 }
 
 } // namespace muduo
\ No newline at end of file
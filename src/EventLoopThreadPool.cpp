@@ -10,6 +10,8 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop, const std::string&
       started_(false),
       numThreads_(0),
       next_(0),
+      busyPollSeconds_(0.0),
+      socketBusyPollUs_(0),
       consistenHash_(5) {
 }
 
@@ -17,9 +19,22 @@ EventLoopThreadPool::~EventLoopThreadPool() {
     // 此处不需要释放EventLoopThread对象，因为EventLoopThread对象是通过std::unique_ptr管理的
 }
 
-void EventLoopThreadPool::start(const ThreadInitCallback& cb) {
+void EventLoopThreadPool::start(const ThreadInitCallback& userCb) {
     started_ = true;
 
+    // 在 IO 线程进入 loop() 之前设置忙轮询，再调用用户的初始化回调
+    ThreadInitCallback cb = userCb;
+    if (busyPollSeconds_ > 0.0 || socketBusyPollUs_ > 0) {
+        double spinSeconds = busyPollSeconds_;
+        int socketBusyPollUs = socketBusyPollUs_;
+        cb = [spinSeconds, socketBusyPollUs, userCb](EventLoop* loop) {
+            loop->setBusyPoll(spinSeconds, socketBusyPollUs);
+            if (userCb) {
+                userCb(loop);
+            }
+        };
+    }
+
     for (int i = 0; i < numThreads_; ++i) {
         char buf[name_.size() + 32];
         snprintf(buf, sizeof buf, "%s%d", name_.c_str(), i);
@@ -0,0 +1,379 @@
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <cstring>
+#include <algorithm>
+
+#include "IoUringPoller.h"
+#include "Channel.h"
+#include "Logger.h"
+
+#ifndef IORING_SETUP_COOP_TASKRUN
+#define IORING_SETUP_COOP_TASKRUN (1U << 8)
+#endif
+#ifndef IORING_FEAT_EXT_ARG
+#define IORING_FEAT_EXT_ARG (1U << 8)
+#endif
+#ifndef IORING_ENTER_EXT_ARG
+#define IORING_ENTER_EXT_ARG (1U << 3)
+#endif
+
+namespace muduo {
+
+namespace {
+
+const int kNew = -1;        // 新 Channel，不在 channels_ 中
+const int kAdded = 1;       // 已在 channels_ 中
+
+// 提交 POLL_REMOVE 时使用的 user_data，其完成事件直接丢弃
+const uint64_t kRemoveUserData = 0;
+
+inline uint64_t makeUserData(int fd, uint32_t seq) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(fd)) << 32) | seq;
+}
+
+template <typename T>
+inline T loadAcquire(const T* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+inline void storeRelease(T* p, T v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+}
+
+const unsigned IoUringPoller::kRingEntries;
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+    : Poller(loop),
+      ringFd_(-1),
+      sqRing_(MAP_FAILED),
+      sqRingSize_(0),
+      cqRing_(MAP_FAILED),
+      cqRingSize_(0),
+      sqes_(static_cast<io_uring_sqe*>(MAP_FAILED)),
+      sqesSize_(0),
+      sqHead_(nullptr),
+      sqTail_(nullptr),
+      sqMask_(0),
+      sqEntries_(0),
+      sqArray_(nullptr),
+      cqHead_(nullptr),
+      cqTail_(nullptr),
+      cqMask_(0),
+      cqes_(nullptr),
+      sqLocalTail_(0),
+      toSubmit_(0),
+      nextSeq_(1) {
+    setupRing();
+}
+
+IoUringPoller::~IoUringPoller() {
+    if (sqes_ != MAP_FAILED) {
+        ::munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_ != MAP_FAILED) {
+        ::munmap(sqRing_, sqRingSize_);
+    }
+    if (ringFd_ >= 0) {
+        ::close(ringFd_);
+    }
+}
+
+bool IoUringPoller::setupRing() {
+    io_uring_params params;
+    ::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = kRingEntries * 2;
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, kRingEntries, &params));
+    if (fd < 0 && errno == EINVAL) {
+        // 5.19 之前的内核不支持 COOP_TASKRUN
+        ::memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = kRingEntries * 2;
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, kRingEntries, &params));
+    }
+    if (fd < 0) {
+        return false;
+    }
+    // 带超时的等待依赖 IORING_ENTER_EXT_ARG（5.11）
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        ::close(fd);
+        errno = ENOSYS;
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    sqLocalTail_ = *sqTail_;
+
+    ringFd_ = fd;
+    return true;
+}
+
+TimeStamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels) {
+    return pollNanos(static_cast<int64_t>(timeoutMs) * 1000 * 1000, activeChannels);
+}
+
+// 等待时间通过 IORING_ENTER_EXT_ARG 的 timespec 传给内核，本身就精确到纳秒
+TimeStamp IoUringPoller::pollNanos(int64_t timeoutNs, ChannelList* activeChannels) {
+    LOG_DEBUG("func = %s => fd total count %lu", __FUNCTION__, channels_.size());
+
+    flushUpdates();
+
+    // 提交本轮积累的增删改，同时等待至少一个完成事件；timeoutNs 为 0 时只提交并处理已完成的事件，不等待
+    int ret;
+    if (timeoutNs == 0) {
+        ret = enter(toSubmit_, 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+    } else {
+        __kernel_timespec ts;
+        ts.tv_sec = timeoutNs / (1000 * 1000 * 1000);
+        ts.tv_nsec = timeoutNs % (1000 * 1000 * 1000);
+        io_uring_getevents_arg arg;
+        ::memset(&arg, 0, sizeof(arg));
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        ret = enter(toSubmit_, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    }
+    int savedErrno = errno;
+    TimeStamp now(TimeStamp::now());
+
+    // 超时和被信号中断都不是错误
+    if (ret < 0 && savedErrno != ETIME && savedErrno != EINTR) {
+        errno = savedErrno;
+        LOG_ERROR("IoUringPoller::poll() - io_uring_enter() error: %d", savedErrno);
+    }
+
+    size_t before = activeChannels->size();
+    fillActiveChannels(activeChannels);
+    if (activeChannels->size() > before) {
+        LOG_DEBUG("%lu events happened", activeChannels->size() - before);
+    } else {
+        LOG_DEBUG("%s => Timeout!", __FUNCTION__);
+    }
+    return now;
+}
+
+void IoUringPoller::updateChannel(Channel* channel) {
+    const int index = channel->index();
+    int fd = channel->fd();
+    LOG_DEBUG("func = %s => fd = %d events = %d index = %d", __FUNCTION__, fd, channel->events(), index);
+
+    if (index == kNew) {
+        channels_[fd] = channel;
+        channel->set_index(kAdded);
+    }
+    entry(fd).channel = channel;
+    // 不立即提交，同一轮中对同一个 Channel 的多次修改合并为一次
+    markDirty(fd);
+}
+
+void IoUringPoller::removeChannel(Channel* channel) {
+    int fd = channel->fd();
+    channels_.erase(fd);
+
+    LOG_DEBUG("func = %s => fd = %d", __FUNCTION__, fd);
+
+    // 已提交的 poll 持有文件的引用，fd 关闭后连接也不会真正关闭（监听 socket 仍占用端口），因此立即提交撤销
+    // 其完成事件按序号丢弃
+    Entry& e = entry(fd);
+    if (e.seq != 0) {
+        queuePollRemove(fd, e);
+        e.seq = 0;
+        enter(toSubmit_, 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+    }
+    e.channel = nullptr;
+    channel->set_index(kNew);
+}
+
+// 撤销 poll 的收尾工作由提交它的线程完成，线程退出后改由内核的工作队列延迟完成
+// 在此之前 poll 一直持有文件的引用，随后在其他线程析构的 TcpServer 关闭监听 socket 时端口不会立即释放
+void IoUringPoller::stopPolling() {
+    for (size_t fd = 0; fd < entries_.size(); ++fd) {
+        Entry& e = entries_[fd];
+        if (e.seq != 0) {
+            queuePollRemove(static_cast<int>(fd), e);
+            e.seq = 0;
+            markDirty(static_cast<int>(fd));
+        }
+    }
+    if (toSubmit_ > 0) {
+        enter(toSubmit_, 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+    }
+}
+
+IoUringPoller::Entry& IoUringPoller::entry(int fd) {
+    if (static_cast<size_t>(fd) >= entries_.size()) {
+        entries_.resize(std::max(static_cast<size_t>(fd) + 1, entries_.size() * 2));
+    }
+    return entries_[fd];
+}
+
+void IoUringPoller::markDirty(int fd) {
+    Entry& e = entry(fd);
+    if (!e.dirty) {
+        e.dirty = true;
+        dirty_.push_back(fd);
+    }
+}
+
+void IoUringPoller::flushUpdates() {
+    // 提交失败时会重新加入 dirty_，留到下一轮
+    updating_.swap(dirty_);
+    for (int fd : updating_) {
+        Entry& e = entries_[fd];
+        e.dirty = false;
+        if (e.channel == nullptr) {
+            continue;
+        }
+        int events = e.channel->events();
+        if (e.seq != 0) {
+            if (e.armedEvents == events) {
+                continue;
+            }
+            // 关注的事件变了：撤销旧的 poll，在它的完成事件到来之前就可以提交新的
+            queuePollRemove(fd, e);
+            e.seq = 0;
+        }
+        if (events != 0) {
+            queuePollAdd(fd, e, events);
+        }
+    }
+    updating_.clear();
+}
+
+io_uring_sqe* IoUringPoller::getSqe() {
+    unsigned tail = sqLocalTail_;
+    if (tail - loadAcquire(sqHead_) >= sqEntries_) {
+        // 提交队列已满，先提交一批，不等待
+        enter(toSubmit_, 0, 0, nullptr, 0);
+        if (tail - loadAcquire(sqHead_) >= sqEntries_) {
+            return nullptr;
+        }
+    }
+    unsigned index = tail & sqMask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    ::memset(sqe, 0, sizeof(*sqe));
+    sqArray_[index] = index;
+    ++sqLocalTail_;
+    ++toSubmit_;
+    return sqe;
+}
+
+void IoUringPoller::queuePollAdd(int fd, Entry& e, int events) {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) {
+        LOG_ERROR("IoUringPoller::queuePollAdd() - submission queue full, fd = %d", fd);
+        markDirty(fd);
+        return;
+    }
+    uint32_t seq = nextSeq_++;
+    if (nextSeq_ == 0) {
+        nextSeq_ = 1;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = static_cast<uint32_t>(events);
+    sqe->user_data = makeUserData(fd, seq);
+    e.seq = seq;
+    e.armedEvents = events;
+}
+
+void IoUringPoller::queuePollRemove(int fd, const Entry& e) {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) {
+        // 撤销不了时旧的 poll 留在内核中，其完成事件同样会因序号不匹配被丢弃
+        LOG_ERROR("IoUringPoller::queuePollRemove() - submission queue full, fd = %d", fd);
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = makeUserData(fd, e.seq);
+    sqe->user_data = kRemoveUserData;
+}
+
+int IoUringPoller::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize) {
+    // 填写完的 SQE 在进入内核前才对内核可见
+    storeRelease(sqTail_, sqLocalTail_);
+    numSyscalls_.fetch_add(1, std::memory_order_relaxed);
+    int ret = static_cast<int>(::syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags, arg, argSize));
+    if (ret >= 0) {
+        toSubmit_ -= std::min(toSubmit_, static_cast<unsigned>(ret));
+    }
+    return ret;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels) {
+    unsigned head = *cqHead_;
+    unsigned tail = loadAcquire(cqTail_);
+    for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = cqes_[head & cqMask_];
+        if (cqe.user_data == kRemoveUserData) {
+            continue;
+        }
+        int fd = static_cast<int>(cqe.user_data >> 32);
+        uint32_t seq = static_cast<uint32_t>(cqe.user_data);
+        // 已被撤销或替换的 poll
+        if (static_cast<size_t>(fd) >= entries_.size() || entries_[fd].seq != seq || entries_[fd].channel == nullptr) {
+            continue;
+        }
+        Entry& e = entries_[fd];
+        e.seq = 0;      // 一次性的 poll 已经触发，下一次 poll() 时重新提交
+        markDirty(fd);
+        int revents = cqe.res;
+        if (revents < 0) {
+            LOG_ERROR("IoUringPoller::fillActiveChannels() - poll fd = %d error: %d", fd, -revents);
+            revents = EPOLLERR;
+        }
+        e.channel->set_revents(revents);
+        activeChannels->push_back(e.channel);
+    }
+    storeRelease(cqHead_, head);
+}
+
+}
@@ -0,0 +1,110 @@
+#include "LengthHeaderCodec.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+namespace muduo {
+
+const size_t LengthHeaderCodec::kHeaderLen;
+const size_t LengthHeaderCodec::kDefaultMaxFrameSize;
+
+namespace {
+
+// 当前线程正在批量回调的连接，回调期间对它的 send 只编码不发送，回调结束后统一 flush
+thread_local TcpConnection* t_batchConn = nullptr;
+
+// 每个 IO 线程复用一个数组存放解码出来的消息视图，避免每次回调都分配内存
+thread_local std::vector<StringPiece> t_frames;
+
+bool appendFrame(ChainBuffer* output, const StringPiece& frame) {
+    int32_t be32 = static_cast<int32_t>(htobe32(static_cast<uint32_t>(frame.size())));
+    return output->append(reinterpret_cast<const char*>(&be32), sizeof be32) &&
+           output->append(frame.data(), frame.size());
+}
+
+}
+
+void LengthHeaderCodec::onMessage(const TcpConnectionPtr& conn, Buffer* buf, TimeStamp receiveTime) {
+    std::vector<StringPiece>& frames = t_frames;
+    frames.clear();
+
+    const char* p = buf->peek();
+    size_t remaining = buf->readableBytes();
+    while (remaining >= kHeaderLen) {
+        uint32_t be32 = 0;
+        ::memcpy(&be32, p, sizeof be32);
+        const size_t len = be32toh(be32);
+        if (len > maxFrameSize_) {
+            LOG_ERROR("LengthHeaderCodec::onMessage [%s] - invalid frame length %zu, max %zu",
+                      conn->name().c_str(), len, maxFrameSize_);
+            buf->retrieveAll();
+            conn->forceClose();
+            return;
+        }
+        if (remaining < kHeaderLen + len) {
+            break;
+        }
+        frames.push_back(StringPiece(p + kHeaderLen, len));
+        p += kHeaderLen + len;
+        remaining -= kHeaderLen + len;
+    }
+
+    if (frames.empty()) {
+        return;
+    }
+
+    // 视图指向 buf 内部，回调结束后再移动读指针
+    TcpConnection* savedBatchConn = t_batchConn;
+    t_batchConn = conn.get();
+    frameBatchCallback_(conn, frames, receiveTime);
+    t_batchConn = savedBatchConn;
+
+    buf->retrieveUntil(p);
+    frames.clear();
+    conn->flush();
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, const StringPiece& frame) {
+    if (!conn->getLoop()->isInLoopThread()) {
+        Buffer buf;
+        encode(&buf, frame);
+        conn->send(&buf);
+        return;
+    }
+    if (!conn->connected()) {
+        return;
+    }
+
+    if (!appendFrame(conn->outputBuffer(), frame)) {
+        // 内存池达到上限，长度头可能已经写入，数据流已经不完整，只能断开连接
+        LOG_ERROR("LengthHeaderCodec::send [%s] - buffer pool exhausted, force close", conn->name().c_str());
+        conn->forceClose();
+        return;
+    }
+    if (conn.get() != t_batchConn) {
+        conn->flush();
+    }
+}
+
+// 长度头写进 body 前部的预留空间，消息体不再单独拷贝一次
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, Buffer* body) {
+    body->prependInt32(static_cast<int32_t>(body->readableBytes()));
+    if (conn->getLoop()->isInLoopThread() && conn.get() == t_batchConn && conn->connected()) {
+        // 批量回调中只追加到发送缓冲区，回调结束后与其他回复合并成一次 writev
+        if (!conn->outputBuffer()->append(body->peek(), body->readableBytes())) {
+            LOG_ERROR("LengthHeaderCodec::send [%s] - buffer pool exhausted, force close", conn->name().c_str());
+            conn->forceClose();
+        }
+        body->retrieveAll();
+        return;
+    }
+    // IO 线程内直接从 body 写出，写不完的部分才进入发送缓冲区；跨线程时整体移交给 IO 线程
+    conn->send(body);
+}
+
+void LengthHeaderCodec::encode(Buffer* buf, const StringPiece& frame) {
+    buf->appendInt32(static_cast<int32_t>(frame.size()));
+    buf->append(frame);
+}
+
+}
@@ -0,0 +1,21 @@
+#include "MonoTime.h"
+
+#include <time.h>
+
+namespace muduo {
+
+const int64_t MonoTime::kNanoSecondsPerSecond;
+
+MonoTime MonoTime::now() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return MonoTime(static_cast<int64_t>(ts.tv_sec) * kNanoSecondsPerSecond + ts.tv_nsec);
+}
+
+MonoTime MonoTime::fromTimeStamp(TimeStamp when) {
+    int64_t deltaUs = when.microSecondsSinceEpoch() - TimeStamp::now().microSecondsSinceEpoch();
+    // TimeStamp 只精确到微秒，多加 1us，换算后不会早于 when
+    return MonoTime(now().nanoSeconds() + (deltaUs + 1) * 1000);
+}
+
+}
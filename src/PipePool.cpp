@@ -0,0 +1,70 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "PipePool.h"
+#include "Logger.h"
+
+namespace muduo {
+
+const size_t PipePool::kDefaultPipeSize;
+const size_t PipePool::kDefaultMaxIdlePipes;
+
+PipePool::PipePool(size_t pipeSize, size_t maxIdlePipes)
+    : pipeSize_(pipeSize),
+      maxIdlePipes_(maxIdlePipes) {}
+
+PipePool::~PipePool() {
+    for (Pipe* pipe : idle_) {
+        closePipe(pipe);
+    }
+}
+
+std::shared_ptr<PipePool::Pipe> PipePool::acquire() {
+    Pipe* pipe = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            pipe = idle_.back();
+            idle_.pop_back();
+        }
+    }
+    if (pipe == nullptr) {
+        int fds[2];
+        if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+            LOG_ERROR("PipePool::acquire - pipe2 failed");
+            return std::shared_ptr<Pipe>();
+        }
+        // 调大容量失败时保留系统默认容量
+        ::fcntl(fds[1], F_SETPIPE_SZ, static_cast<int>(pipeSize_));
+        int capacity = ::fcntl(fds[1], F_GETPIPE_SZ);
+        pipe = new Pipe{fds[0], fds[1], capacity > 0 ? static_cast<size_t>(capacity) : 65536, 0};
+    }
+
+    // 归还时持有内存池的引用，保证管道晚于 EventLoop 释放时内存池仍然有效
+    std::shared_ptr<PipePool> self = shared_from_this();
+    return std::shared_ptr<Pipe>(pipe, [self](Pipe* p) { self->release(p); });
+}
+
+size_t PipePool::numIdle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+void PipePool::release(Pipe* pipe) {
+    if (pipe->buffered == 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < maxIdlePipes_) {
+            idle_.push_back(pipe);
+            return;
+        }
+    }
+    closePipe(pipe);
+}
+
+void PipePool::closePipe(Pipe* pipe) {
+    ::close(pipe->readFd);
+    ::close(pipe->writeFd);
+    delete pipe;
+}
+
+}
@@ -6,7 +6,8 @@
 namespace muduo {
 
 Poller::Poller(EventLoop* loop)
-    : ownerLoop_(loop) {}
+    : numSyscalls_(0),
+      ownerLoop_(loop) {}
 
 Poller::~Poller() {}
 
@@ -15,4 +16,9 @@ bool Poller::hasChannel(Channel* channel) const {
     return it != channels_.end() && it->second == channel;
 }
 
+TimeStamp Poller::pollNanos(int64_t timeoutNs, ChannelList* activeChannels) {
+    const int64_t kNanoSecondsPerMs = 1000 * 1000;
+    return poll(static_cast<int>((timeoutNs + kNanoSecondsPerMs - 1) / kNanoSecondsPerMs), activeChannels);
+}
+
 }
\ No newline at end of file
@@ -4,6 +4,11 @@
 
 #include <unistd.h>
 #include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69      // Linux 5.11
+#endif
 
 namespace muduo {
 
@@ -85,4 +90,33 @@ void Socket::setTcpNoDelay(bool on) {
     }
 }
 
+bool Socket::setZeroCopy(bool on) {
+    int optval = on ? 1 : 0;
+    if (0 != ::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &optval, static_cast<socklen_t>(sizeof(optval)))) {
+        LOG_ERROR("Socket::setZeroCopy sockfd_=%d failed", sockfd_);
+        return false;
+    }
+    return true;
+}
+
+void Socket::setAbortOnClose() {
+    struct linger optval = {1, 0};
+    if (0 != ::setsockopt(sockfd_, SOL_SOCKET, SO_LINGER, &optval, static_cast<socklen_t>(sizeof(optval)))) {
+        LOG_ERROR("Socket::setAbortOnClose sockfd_=%d failed", sockfd_);
+    }
+}
+
+bool Socket::setBusyPoll(int usec, bool prefer) {
+    if (0 != ::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL, &usec, static_cast<socklen_t>(sizeof(usec)))) {
+        LOG_ERROR("Socket::setBusyPoll sockfd_=%d SO_BUSY_POLL failed", sockfd_);
+        return false;
+    }
+    int optval = prefer ? 1 : 0;
+    if (prefer && 0 != ::setsockopt(sockfd_, SOL_SOCKET, SO_PREFER_BUSY_POLL, &optval, static_cast<socklen_t>(sizeof(optval)))) {
+        LOG_ERROR("Socket::setBusyPoll sockfd_=%d SO_PREFER_BUSY_POLL failed", sockfd_);
+        return false;
+    }
+    return true;
+}
+
 }
\ No newline at end of file
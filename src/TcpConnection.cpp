@@ -1,4 +1,5 @@
 #include <functional>
+#include <algorithm>
 #include <memory>
 #include <cerrno>
 #include <cstring>
@@ -6,6 +7,11 @@
 #include <unistd.h>
 #include <netinet/tcp.h>
 #include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <climits>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
 
 #include "TcpConnection.h"
 #include "Channel.h"
@@ -14,6 +20,15 @@
 #include "Logger.h"
 
 namespace muduo {
+
+// 输入缓冲区被突发流量撑到超过该容量后，数据取空时收缩回初始大小
+const size_t kMaxIdleInputBufferSize = 64 * 1024;
+
+// 等待零拷贝完成通知时轮询错误队列的间隔，从最小值开始指数退避；连接关闭后最多等待的时间
+const double kZeroCopyPollMinSeconds = 0.001;
+const double kZeroCopyPollMaxSeconds = 0.1;
+const double kZeroCopyLingerSeconds = 10.0;
+
 static EventLoop *CheckLoopNotNull(EventLoop *loop) {
     if (loop == nullptr) {
         LOG_FATAL("%s:%s:%d mainLoop is null.", __FILE__, __func__, __LINE__);
@@ -34,33 +49,150 @@ TcpConnection::TcpConnection(EventLoop *loop,
       channel_(new Channel(loop, sockfd)),
       localAddr_(localAddr),
       peerAddr_(peerAddr),
-      highWaterMark_(64 * 1024 * 1024)
+      highWaterMark_(64 * 1024 * 1024),
+      lowWaterMark_(0),
+      aboveHighWater_(false),
+      autoCork_(false),
+      flushQueued_(false),
+      numSendCalls_(0),
+      numWriteSyscalls_(0),
+      zeroCopyThreshold_(0),
+      zeroCopyNextSeq_(0),
+      zeroCopyLingering_(false),
+      numZeroCopySends_(0),
+      numZeroCopyCompletions_(0),
+      numZeroCopyCopied_(0),
+      outputBuffer_(loop_->bufferPool()),
+      queuedBytes_(0),
+      splicePaused_(false),
+      spliceReadEof_(false)
 {
+    std::fill(idleTimeoutNs_, idleTimeoutNs_ + kNumIdleTypes, 0);
     LOG_DEBUG("TcpConnection::create [%s] at %p fd=%d", name_.c_str(), this, sockfd);
     channel_->setReadCallback(std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
     channel_->setWriteCallback(std::bind(&TcpConnection::handleWrite, this));
     channel_->setCloseCallback(std::bind(&TcpConnection::handleClose, this));
     channel_->setErrorCallback(std::bind(&TcpConnection::handleError, this));
+    channel_->setErrorQueueCallback(std::bind(&TcpConnection::handleErrorQueue, this));
     socket_->setKeepAlive(true);
+    int busyPollUs = loop_->socketBusyPollUs();
+    if (busyPollUs > 0 && !socket_->setBusyPoll(busyPollUs, true)) {
+        loop_->disableSocketBusyPoll();
+    }
 }
 
 TcpConnection::~TcpConnection() {
     LOG_DEBUG("TcpConnection::destroy [%s] at %p fd=%d state=%d", name_.c_str(), this, channel_->fd(), (int)state_);
+    // 等不到完成通知（对端长时间不确认，或者 EventLoop 退出）：先以 RST 关闭，内核丢弃发送队列、
+    // 不再引用这些页面之后，才随成员析构释放数据
+    if (!zeroCopyInflight_.empty()) {
+        LOG_ERROR("TcpConnection::destroy [%s] - %zu zero-copy sends not completed, abort",
+                  name_.c_str(), zeroCopyInflight_.size());
+        socket_->setAbortOnClose();
+        socket_.reset();
+    }
 }
 
-void TcpConnection::send(const std::string &buf) {
+void TcpConnection::send(const StringPiece &message) {
     if (state_ == kConnected) {
         // 如果是单Reactor，loop_即为当前线程的EventLoop，可以直接调用sendInLoop
         // 否则需要将sendInLoop任务添加到EventLoop的任务队列中
+        // 跨线程时 message 指向的内存可能在任务执行前失效，所以要拷贝一份 std::string 绑定到任务中
+        if (loop_->isInLoopThread()) {
+            sendInLoop(message.data(), message.size());
+        } else {
+            void (TcpConnection::*fp)(const StringPiece&) = &TcpConnection::sendInLoop;
+            loop_->runInLoop(std::bind(fp, shared_from_this(), message.as_string()));
+        }
+    }
+}
+
+void TcpConnection::send(const void *data, size_t len) {
+    send(StringPiece(static_cast<const char *>(data), len));
+}
+
+// 无论连接状态如何 buf 都会被清空，连接已断开时数据被丢弃，避免调用方的缓冲区无限堆积
+void TcpConnection::send(Buffer *buf) {
+    if (state_ == kConnected) {
         if (loop_->isInLoopThread()) {
-            sendInLoop(buf.c_str(), buf.size());
+            sendInLoop(buf->peek(), buf->readableBytes());
+            buf->retrieveAll();
         } else {
-            loop_->runInLoop(std::bind(&TcpConnection::sendInLoop, this, buf.c_str(), buf.size()));
+            void (TcpConnection::*fp)(const StringPiece&) = &TcpConnection::sendInLoop;
+            loop_->runInLoop(std::bind(fp, shared_from_this(), buf->retrieveAllAsString()));
         }
+    } else {
+        buf->retrieveAll();
     }
 }
 
+// 跨线程时把 message 移动进任务，任务持有 shared_ptr 保证执行时连接对象仍然存在
+// 达到零拷贝阈值的数据直接移动进任务交给 sendZeroCopyInLoop，由连接持有直到内核发送完成，不需要额外的堆分配
+// 短字符串存放在对象内部（SSO），移动后地址会变，不能零拷贝发送
+void TcpConnection::send(std::string &&message) {
+    if (state_ == kConnected) {
+        size_t threshold = zeroCopyThreshold_.load(std::memory_order_relaxed);
+        if (threshold > 0 && message.size() >= threshold && message.size() >= sizeof(std::string)) {
+            void (TcpConnection::*fp)(std::string&) = &TcpConnection::sendZeroCopyInLoop;
+            loop_->runInLoop(std::bind(fp, shared_from_this(), std::move(message)));
+        } else if (loop_->isInLoopThread()) {
+            sendInLoop(message.data(), message.size());
+        } else {
+            void (TcpConnection::*fp)(const StringPiece&) = &TcpConnection::sendInLoop;
+            loop_->runInLoop(std::bind(fp, shared_from_this(), std::move(message)));
+        }
+    }
+}
+
+void TcpConnection::send(Buffer &&buf) {
+    if (state_ == kConnected) {
+        size_t threshold = zeroCopyThreshold_.load(std::memory_order_relaxed);
+        if (threshold > 0 && buf.readableBytes() >= threshold) {
+            // 调用方的 buf 换成一个最小的空 Buffer，仍然可以继续使用
+            Buffer payload(0);
+            payload.swap(buf);
+            void (TcpConnection::*fp)(Buffer&) = &TcpConnection::sendZeroCopyInLoop;
+            loop_->runInLoop(std::bind(fp, shared_from_this(), std::move(payload)));
+        } else if (loop_->isInLoopThread()) {
+            sendInLoop(buf.peek(), buf.readableBytes());
+            buf.retrieveAll();
+        } else {
+            // 与一个新的 Buffer 交换，调用方的 buf 仍然可以继续使用
+            Buffer payload;
+            payload.swap(buf);
+            loop_->runInLoop(std::bind(&TcpConnection::sendBufferInLoop, shared_from_this(), std::move(payload)));
+        }
+    } else {
+        buf.retrieveAll();
+    }
+}
+
+void TcpConnection::sendBufferInLoop(const Buffer &buf) {
+    sendInLoop(buf.peek(), buf.readableBytes());
+}
+
+// 跨线程时分片指向的内存可能在任务执行前失效，只能拼接拷贝成一个 std::string
+void TcpConnection::send(const struct iovec *iov, int iovcnt) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(iov, iovcnt);
+        } else {
+            std::string message;
+            for (int i = 0; i < iovcnt; ++i) {
+                message.append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+            }
+            void (TcpConnection::*fp)(const StringPiece&) = &TcpConnection::sendInLoop;
+            loop_->runInLoop(std::bind(fp, shared_from_this(), std::move(message)));
+        }
+    }
+}
+
+void TcpConnection::sendInLoop(const StringPiece &message) {
+    sendInLoop(message.data(), message.size());
+}
+
 void TcpConnection::sendInLoop(const void *data, size_t len) {
+    ++numSendCalls_;
     ssize_t nwrote = 0;
     size_t remaining = len;
     bool faultError = false;
@@ -70,10 +202,13 @@ void TcpConnection::sendInLoop(const void *data, size_t len) {
     }
 
     // 如果channel_没有关注写事件(第一次发送数据)或者output buffer没有数据
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) {
+    // 开启 autoCork 时不直接写，先追加到 output buffer，本轮事件循环结束时统一写出
+    if (!autoCork_ && !channel_->isWriting() && !outputPending()) {
+        ++numWriteSyscalls_;
         nwrote = ::write(channel_->fd(), data, len);
         if (nwrote >= 0) {
             remaining = len - nwrote;
+            lastWriteTime_ = loop_->pollReturnMonoTime();
 
             if (remaining == 0 && writeCompleteCallback_) {
                 loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
@@ -91,19 +226,495 @@ void TcpConnection::sendInLoop(const void *data, size_t len) {
 
     // 如果没有写完，将剩余数据添加到output buffer中
     if (!faultError && remaining > 0) {
-        size_t oldLen = outputBuffer_.readableBytes();
-        if (oldLen + remaining >= highWaterMark_ && oldLen < highWaterMark_ && highWaterMarkCallback_) {
-            loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+        checkHighWaterMark(pendingOutputBytes() + remaining);
+        if (!outputBuffer_.append(static_cast<const char *>(data) + nwrote, remaining)) {
+            // 内存池达到上限，无法缓存剩余数据，只能断开连接
+            LOG_ERROR("TcpConnection::sendInLoop [%s] - buffer pool exhausted, force close", name_.c_str());
+            forceCloseInLoop();
+            return;
         }
-        outputBuffer_.append(static_cast<const char *>(data) + nwrote, remaining);
 
         // 如果channel_没有关注写事件，需要关注写事件，否则会漏写数据
         if (!channel_->isWriting()) {
-            channel_->enableWriting();
+            if (autoCork_) {
+                queueCorkedFlush();
+            } else {
+                channel_->enableWriting();
+            }
+        }
+    }
+}
+
+void TcpConnection::flush() {
+    loop_->assertInLoopThread();
+    // 已经在等待可写事件时由 handleWrite 负责发送
+    if (state_ == kDisconnected || channel_->isWriting() || !outputPending()) {
+        return;
+    }
+
+    if (!drainOutput()) {
+        return;
+    }
+    // 编解码器等直接写进 outputBuffer() 的数据在这里才计入水位
+    checkHighWaterMark();
+    checkLowWaterMark();
+
+    if (!outputPending()) {
+        if (writeCompleteCallback_) {
+            loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        }
+        if (state_ == kDisconnecting) {
+            shutdownInLoop();
+        }
+    } else {
+        channel_->enableWriting();
+    }
+}
+
+/**
+ * 按数据流顺序写出 outputBuffer_ 与输出队列，直到全部写完或者 socket 发送缓冲区写满
+ * 队首特殊发送项之前的缓冲区数据先写，然后写该项，依此类推
+ * 返回 false 表示出错，此时连接已经由 abortOutput 断开
+ */
+bool TcpConnection::drainOutput() {
+    if (!writeOutput()) {
+        abortOutput();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 写出错（对端重置、sendfile 的文件比预期的短、管道中的数据丢失）之后剩余的数据再也发不出去，
+ * 不丢弃的话水平触发的 EPOLLOUT 会不停地回调 handleWrite，所以丢弃全部待发送数据并断开连接
+ * 转发到本连接的 splice 数据已经丢失，来源连接也一起断开
+ */
+void TcpConnection::abortOutput() {
+    for (const OutputEntry &entry : outputQueue_) {
+        if (entry.type == OutputEntry::kPipe) {
+            TcpConnectionPtr source = entry.source.lock();
+            if (source) {
+                source->forceClose();
+            }
+        }
+    }
+    for (OutputEntry &entry : outputQueue_) {
+        retireEntry(entry);
+    }
+    outputQueue_.clear();
+    queuedBytes_ = 0;
+    outputBuffer_.retrieveAll();
+    if (channel_->isWriting()) {
+        channel_->disableWriting();
+    }
+    forceCloseInLoop();
+}
+
+// 发送项出队：零拷贝的数据交给它最后一次 MSG_ZEROCOPY send 的记录，等这次及之前的完成通知都到达后才释放
+void TcpConnection::retireEntry(OutputEntry &entry) {
+    if (entry.type == OutputEntry::kZeroCopy && entry.zeroCopySent) {
+        zeroCopyInflight_.back().owner = std::move(entry.owner);
+    }
+}
+
+bool TcpConnection::writeOutput() {
+    while (true) {
+        uint64_t limit = outputQueue_.empty()
+                       ? outputBuffer_.readableBytes()
+                       : outputQueue_.front().streamOffset - outputBuffer_.totalRetrieved();
+        if (limit > 0) {
+            int savedErrno = 0;
+            ++numWriteSyscalls_;
+            ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno, limit);
+            if (n < 0) {
+                if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+                    return true;
+                }
+                errno = savedErrno;
+                LOG_ERROR("TcpConnection::drainOutput");
+                return false;
+            }
+            outputBuffer_.retrieve(n);
+            lastWriteTime_ = loop_->pollReturnMonoTime();
+            if (static_cast<uint64_t>(n) < limit) {     // 发送缓冲区已满，等待下一次可写事件
+                return true;
+            }
+            continue;
+        }
+
+        if (outputQueue_.empty()) {
+            return true;
+        }
+        bool faultError = false;
+        if (!writeEntry(outputQueue_.front(), &faultError)) {
+            return !faultError;
         }
+        retireEntry(outputQueue_.front());
+        outputQueue_.pop_front();
     }
 }
 
+// 发送一个特殊发送项，全部发送完毕返回 true
+bool TcpConnection::writeEntry(OutputEntry &entry, bool *faultError) {
+    while (entry.sent < entry.len) {
+        ssize_t n = 0;
+        int flags = 0;
+        ++numWriteSyscalls_;
+        if (entry.type == OutputEntry::kFile) {
+            n = ::sendfile(channel_->fd(), entry.fileFd, &entry.fileOffset, entry.len - entry.sent);
+            if (n == 0) {   // 文件比预期的短
+                LOG_ERROR("TcpConnection::writeEntry [%s] - unexpected end of file fd=%d", name_.c_str(), entry.fileFd);
+                *faultError = true;
+                return false;
+            }
+        } else if (entry.type == OutputEntry::kPipe) {
+            n = ::splice(entry.pipe->readFd, nullptr, channel_->fd(), nullptr, entry.len - entry.sent,
+                         SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n == 0) {   // 管道中的数据比记录的少，不应该发生
+                LOG_ERROR("TcpConnection::writeEntry [%s] - pipe drained unexpectedly", name_.c_str());
+                *faultError = true;
+                return false;
+            }
+        } else {
+            flags = MSG_NOSIGNAL | MSG_ZEROCOPY;
+            n = ::send(channel_->fd(), entry.data + entry.sent, entry.len - entry.sent, flags);
+            if (n < 0 && errno == ENOBUFS) {
+                // 锁定页面超过 optmem 限制时退化为普通的拷贝发送
+                flags = MSG_NOSIGNAL;
+                ++numWriteSyscalls_;
+                n = ::send(channel_->fd(), entry.data + entry.sent, entry.len - entry.sent, flags);
+            }
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("TcpConnection::writeEntry");
+                *faultError = true;
+            }
+            return false;
+        }
+        if (flags & MSG_ZEROCOPY) {
+            // 每次成功的 MSG_ZEROCOPY 发送对应内核中的一个序号，完成通知按序号区间送回
+            ZeroCopyInflight inflight = {zeroCopyNextSeq_++, false, Task()};
+            zeroCopyInflight_.push_back(std::move(inflight));
+            entry.zeroCopySent = true;
+            ++numZeroCopySends_;
+        }
+        entry.sent += n;
+        queuedBytes_ -= n;
+        lastWriteTime_ = loop_->pollReturnMonoTime();
+        if (entry.type == OutputEntry::kPipe) {
+            entry.pipe->buffered -= n;
+            TcpConnectionPtr source = entry.source.lock();
+            if (source) {
+                source->onSpliceDrained();
+            }
+        }
+    }
+    return true;
+}
+
+namespace {
+
+// 只用来持有零拷贝发送的数据，放进只能移动的 Task 中内联存放；移动 std::string（非 SSO）和 Buffer 不改变数据的地址
+template <typename T>
+struct PayloadHolder {
+    T payload;
+    void operator()() {}
+};
+
+}
+
+void TcpConnection::sendZeroCopyInLoop(std::string &message) {
+    const char* data = message.data();
+    size_t len = message.size();
+    PayloadHolder<std::string> holder = {std::move(message)};
+    queueZeroCopy(Task(std::move(holder)), data, len);
+}
+
+void TcpConnection::sendZeroCopyInLoop(Buffer &buf) {
+    const char* data = buf.peek();
+    size_t len = buf.readableBytes();
+    PayloadHolder<Buffer> holder = {std::move(buf)};   // buf 是任务中绑定的参数，调用结束后随任务销毁
+    queueZeroCopy(Task(std::move(holder)), data, len);
+}
+
+void TcpConnection::queueZeroCopy(Task owner, const char *data, size_t len) {
+    if (state_ == kDisconnected) {
+        LOG_ERROR("disconnected, give up writing");
+        return;
+    }
+    ++numSendCalls_;
+
+    OutputEntry entry;
+    entry.type = OutputEntry::kZeroCopy;
+    entry.streamOffset = outputBuffer_.totalAppended();
+    entry.owner = std::move(owner);
+    entry.data = data;
+    entry.zeroCopySent = false;
+    entry.len = len;
+    entry.sent = 0;
+    entry.fileFd = -1;
+    entry.fileOffset = 0;
+    outputQueue_.push_back(std::move(entry));
+    queuedBytes_ += len;
+    checkHighWaterMark();
+
+    if (!channel_->isWriting()) {
+        if (autoCork_) {
+            queueCorkedFlush();
+        } else {
+            flush();
+        }
+    }
+}
+
+bool TcpConnection::setZeroCopyThreshold(size_t threshold) {
+    if (threshold > 0 && !socket_->setZeroCopy(true)) {
+        zeroCopyThreshold_ = 0;
+        return false;
+    }
+    zeroCopyThreshold_ = threshold;
+    return true;
+}
+
+/**
+ * 取出错误队列中的 MSG_ZEROCOPY 完成通知，释放内核已经用完的数据
+ * 每个通知给出一个已完成的序号区间 [ee_info, ee_data]，ee_code 带有 SO_EE_CODE_ZEROCOPY_COPIED 表示内核实际做了拷贝
+ */
+bool TcpConnection::handleErrorQueue() {
+    if (zeroCopyInflight_.empty()) {
+        return false;
+    }
+
+    bool handled = false;
+    while (true) {
+        char control[128];
+        struct msghdr msg;
+        ::memset(&msg, 0, sizeof msg);
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof control;
+        if (::recvmsg(channel_->fd(), &msg, MSG_ERRQUEUE) < 0) {
+            break;
+        }
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+                !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) {
+                continue;
+            }
+            const struct sock_extended_err *serr = reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cm));
+            if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            handled = true;
+            const uint32_t lo = serr->ee_info;
+            const uint32_t hi = serr->ee_data;
+            const uint32_t count = hi - lo + 1;
+            numZeroCopyCompletions_ += count;
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                numZeroCopyCopied_ += count;
+            }
+            for (ZeroCopyInflight &z : zeroCopyInflight_) {
+                if (z.seq - lo <= hi - lo) {
+                    z.done = true;
+                }
+            }
+        }
+    }
+    while (!zeroCopyInflight_.empty() && zeroCopyInflight_.front().done) {
+        zeroCopyInflight_.pop_front();
+    }
+    // 半关闭一直在等最后的完成通知
+    if (handled && zeroCopyInflight_.empty() && state_ == kDisconnecting) {
+        shutdownInLoop();
+    }
+    return handled;
+}
+
+/**
+ * 零拷贝发出的数据在内核送回完成通知之前一直引用着 owner 的内存，内存被提前释放、复用之后，
+ * 重传或者还在排队的数据就会被改写。半关闭和连接销毁时都要等这些通知：此时 epoll 可能已经不再关注该 fd，
+ * 所以由定时器轮询错误队列，间隔从 1ms 指数退避到 100ms；定时器持有连接，fd 在此期间保持打开
+ * 连接已经销毁时，从开始轮询算起最多等待 kZeroCopyLingerSeconds，之后由析构函数以 RST 关闭
+ */
+void TcpConnection::lingerZeroCopy(double interval, double waited) {
+    handleErrorQueue();
+    if (zeroCopyInflight_.empty() || (state_ == kDisconnected && waited >= kZeroCopyLingerSeconds)) {
+        zeroCopyLingering_ = false;
+        return;
+    }
+    zeroCopyLingering_ = true;
+    TcpConnectionPtr guardThis(shared_from_this());
+    double next = std::min(interval * 2, kZeroCopyPollMaxSeconds);
+    loop_->runAfter(interval, [guardThis, next, waited, interval]() {
+        guardThis->lingerZeroCopy(next, waited + interval);
+    });
+}
+
+void TcpConnection::sendInLoop(const struct iovec *iov, int iovcnt) {
+    ++numSendCalls_;
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        len += iov[i].iov_len;
+    }
+    ssize_t nwrote = 0;
+    size_t remaining = len;
+    bool faultError = false;
+    if (state_ == kDisconnected) {
+        LOG_ERROR("disconnected, give up writing");
+        return;
+    }
+
+    // 与 sendInLoop(data, len) 相同，只有在没有积压数据时才直接写，超过 IOV_MAX 的分片留给 outputBuffer_
+    if (!autoCork_ && !channel_->isWriting() && !outputPending()) {
+        ++numWriteSyscalls_;
+        nwrote = ::writev(channel_->fd(), iov, std::min(iovcnt, IOV_MAX));
+        if (nwrote >= 0) {
+            remaining = len - nwrote;
+            lastWriteTime_ = loop_->pollReturnMonoTime();
+
+            if (remaining == 0 && writeCompleteCallback_) {
+                loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+        } else {
+            nwrote = 0;
+            if (errno != EWOULDBLOCK) {
+                LOG_ERROR("TcpConnection::sendInLoop");
+                if (errno == EPIPE || errno == ECONNRESET) {
+                    faultError = true;
+                }
+            }
+        }
+    }
+
+    // 跳过已经写出的部分，剩余的分片逐个追加到 output buffer，不需要先拼接
+    if (!faultError && remaining > 0) {
+        checkHighWaterMark(pendingOutputBytes() + remaining);
+        size_t skip = nwrote;
+        for (int i = 0; i < iovcnt; ++i) {
+            if (skip >= iov[i].iov_len) {
+                skip -= iov[i].iov_len;
+                continue;
+            }
+            if (!outputBuffer_.append(static_cast<const char *>(iov[i].iov_base) + skip, iov[i].iov_len - skip)) {
+                LOG_ERROR("TcpConnection::sendInLoop [%s] - buffer pool exhausted, force close", name_.c_str());
+                forceCloseInLoop();
+                return;
+            }
+            skip = 0;
+        }
+
+        if (!channel_->isWriting()) {
+            if (autoCork_) {
+                queueCorkedFlush();
+            } else {
+                channel_->enableWriting();
+            }
+        }
+    }
+}
+
+/**
+ * 每轮事件循环最多排队一次 flush：handleRead 等事件回调中的多次 send 只追加数据，
+ * 等事件处理完毕后在 doPendingFunctors 中一次 writev 写出，减少系统调用次数和小包数量
+ * 在 doPendingFunctors 中发起的 send（例如跨线程 send）会唤醒下一轮循环再写出
+ */
+void TcpConnection::queueCorkedFlush() {
+    if (!flushQueued_) {
+        flushQueued_ = true;
+        loop_->queueInLoop(std::bind(&TcpConnection::corkedFlush, shared_from_this()));
+    }
+}
+
+void TcpConnection::corkedFlush() {
+    flushQueued_ = false;
+    flush();
+}
+
+void TcpConnection::setAutoCork(bool on) {
+    autoCork_ = on;
+}
+
+void TcpConnection::setIdleTimeout(double readerIdleSeconds, double writerIdleSeconds, double allIdleSeconds) {
+    const double seconds[kNumIdleTypes] = {readerIdleSeconds, writerIdleSeconds, allIdleSeconds};
+    for (int type = 0; type < kNumIdleTypes; ++type) {
+        idleTimeoutNs_[type] = static_cast<int64_t>(std::max(seconds[type], 0.0) * MonoTime::kNanoSecondsPerSecond);
+    }
+    // 已经建立的连接按新的超时重新定时
+    if (state_ == kConnected) {
+        if (idleTimer_.valid()) {
+            loop_->cancel(idleTimer_);
+            idleTimer_ = TimerId();
+        }
+        armIdleTimer();
+    }
+}
+
+MonoTime TcpConnection::lastActivity(int type) const {
+    switch (type) {
+    case kReaderIdle:
+        return lastReadTime_;
+    case kWriterIdle:
+        return lastWriteTime_;
+    default:
+        return std::max(lastReadTime_, lastWriteTime_);
+    }
+}
+
+// 最后一次活动（或者上一次报告空闲）之后再过一个超时周期
+MonoTime TcpConnection::idleDeadline(int type) const {
+    return MonoTime(std::max(lastActivity(type), idleSince_[type]).nanoSeconds() + idleTimeoutNs_[type]);
+}
+
+// 按各类空闲中最早的截止时间定时，已经有定时器或者没有开启空闲检测时什么也不做
+void TcpConnection::armIdleTimer() {
+    if (idleTimer_.valid()) {
+        return;
+    }
+    MonoTime next = MonoTime::invalid();
+    for (int type = 0; type < kNumIdleTypes; ++type) {
+        if (idleTimeoutNs_[type] > 0 && (!next.valid() || idleDeadline(type) < next)) {
+            next = idleDeadline(type);
+        }
+    }
+    if (!next.valid()) {
+        return;
+    }
+    std::weak_ptr<TcpConnection> weakConn(shared_from_this());
+    idleTimer_ = loop_->runAt(next, [weakConn]() {
+        TcpConnectionPtr conn = weakConn.lock();
+        if (conn) {
+            conn->handleIdleTimer();
+        }
+    });
+}
+
+// 期间有过读写的类型截止时间已经随时间戳推后，只报告真正到期的，再按推后的截止时间重新定时
+void TcpConnection::handleIdleTimer() {
+    idleTimer_ = TimerId();
+    if (state_ != kConnected) {
+        return;
+    }
+    const MonoTime now = MonoTime::now();
+    TcpConnectionPtr guardThis(shared_from_this());
+    for (int type = 0; type < kNumIdleTypes; ++type) {
+        if (idleTimeoutNs_[type] <= 0 || now < idleDeadline(type)) {
+            continue;
+        }
+        if (!idleCallback_) {
+            LOG_DEBUG("TcpConnection::handleIdleTimer [%s] - idle for %.3f s, force close",
+                      name_.c_str(), timeDifference(now, lastActivity(type)));
+            forceCloseInLoop();
+            return;
+        }
+        idleSince_[type] = now;
+        idleCallback_(guardThis, static_cast<IdleType>(type));
+        if (state_ != kConnected) {
+            return;
+        }
+    }
+    armIdleTimer();
+}
+
 void TcpConnection::shutdown() {
     if (state_ == kConnected) {
         setState(kDisconnecting);
@@ -112,8 +723,58 @@ void TcpConnection::shutdown() {
 }
 
 void TcpConnection::shutdownInLoop() {
-    if (!channel_->isWriting()) {   // 说明output buffer中的数据已经发送完毫无疑问
+    // 没有关注写事件且缓冲区为空，说明output buffer中的数据已经发送完毕
+    // 直接编码进 outputBuffer() 但还没有 flush 的数据由 flush 写完后再关闭
+    // 零拷贝的数据还在等完成通知时先不关闭，由 handleErrorQueue 收到最后的通知后再关闭
+    if (!channel_->isWriting() && !outputPending()) {
+        if (!zeroCopyInflight_.empty()) {
+            if (!zeroCopyLingering_) {
+                lingerZeroCopy(kZeroCopyPollMinSeconds, 0);
+            }
+            return;
+        }
         socket_->shutdownWrite();
+        // splice 转发中读方向已经结束，两个方向都结束后断开连接
+        if (spliceReadEof_ && state_ == kDisconnecting) {
+            handleClose();
+        }
+    }
+}
+
+void TcpConnection::startRead() {
+    loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopRead() {
+    loop_->runInLoop(std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+// 连接已经断开、读到过 EOF 或者 splice 管道已满时只记录意愿，条件满足后再开始读
+void TcpConnection::startReadInLoop() {
+    reading_ = true;
+    bool open = (state_ == kConnected || state_ == kDisconnecting);
+    if (open && !spliceReadEof_ && !splicePaused_ && !channel_->isReading()) {
+        channel_->enableReading();
+    }
+}
+
+void TcpConnection::stopReadInLoop() {
+    reading_ = false;
+    if (channel_->isReading()) {
+        channel_->disableReading();
+    }
+}
+
+void TcpConnection::forceClose() {
+    if (state_ == kConnected || state_ == kDisconnecting) {
+        setState(kDisconnecting);
+        loop_->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop() {
+    if (state_ == kConnected || state_ == kDisconnecting) {
+        handleClose();
     }
 }
 
@@ -123,11 +784,19 @@ void TcpConnection::connectEstablished() {
     channel_->tie(shared_from_this());
     channel_->enableReading();
 
+    lastReadTime_ = lastWriteTime_ = MonoTime::now();
     connectionCallback_(shared_from_this());
+    // 连接回调中设置的空闲超时也在这里生效
+    armIdleTimer();
 }
 
 // 连接销毁
 void TcpConnection::connectDestroyed() {
+    // 空闲检测的定时器不必等到期，立即释放
+    if (idleTimer_.valid()) {
+        loop_->cancel(idleTimer_);
+        idleTimer_ = TimerId();
+    }
     if (state_ == kConnected) {
         setState(kDisconnected);
         channel_->disableAll();
@@ -135,14 +804,31 @@ void TcpConnection::connectDestroyed() {
         connectionCallback_(shared_from_this());
     }
     channel_->remove();
+    if (!zeroCopyInflight_.empty() && !zeroCopyLingering_) {
+        lingerZeroCopy(kZeroCopyPollMinSeconds, 0);
+    }
 }
 
 // 当对端有数据到达时，检测到EPOLLIN事件，调用handleRead 取走数据
 void TcpConnection::handleRead(TimeStamp receiveTime) {
+    lastReadTime_ = loop_->pollReturnMonoTime();
+    if (splicePipe_) {
+        handleSpliceRead();
+        return;
+    }
     int savedErrno = 0;
     ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
     if (n > 0) {
         messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+        // 数据取空后把被突发流量撑大的内存还回去，避免大量空闲连接长期占着峰值内存
+        // 仍在持续大流量读取的连接（readSizeHint 较大）保留预留空间，避免每次读都重新分配
+        // 输入缓冲区不使用 BufferPool：消息回调和编解码器需要连续的可读数据（peek()），
+        // 突发的数据先溢出到 readFd 栈上的临时空间，撑大的部分在这里收缩
+        size_t hint = inputBuffer_.readSizeHint();
+        if (inputBuffer_.readableBytes() == 0 &&
+            inputBuffer_.internalCapacity() > std::max(kMaxIdleInputBufferSize, 2 * hint)) {
+            inputBuffer_.shrink(hint);
+        }
     } else if (n == 0) {
         handleClose();
     } else {
@@ -155,23 +841,17 @@ void TcpConnection::handleRead(TimeStamp receiveTime) {
 // 当output buffer可写时，检测到EPOLLOUT事件，调用handleWrite 发送数据
 void TcpConnection::handleWrite() {
     if (channel_->isWriting()) {
-        int savedErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
-        if (n > 0) {
-            outputBuffer_.retrieve(n);  // 修正偏移量
-            if (outputBuffer_.readableBytes() == 0) {   // 数据发送完毕
-                channel_->disableWriting();
-                if (writeCompleteCallback_) {
-                    loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
-                }
-                if (state_ == kDisconnecting) { // 如果是半关闭状态，关闭连接
-                    shutdownInLoop();
-                }
+        if (!drainOutput()) {
+            return;
+        }
+        checkLowWaterMark();
+        if (!outputPending()) {   // 数据发送完毕
+            channel_->disableWriting();
+            if (writeCompleteCallback_) {
+                loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
             }
-        } else {
-            errno = savedErrno;
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                LOG_ERROR("TcpConnection::handleWrite");
+            if (state_ == kDisconnecting) { // 如果是半关闭状态，关闭连接
+                shutdownInLoop();
             }
         }
     } else {
@@ -179,11 +859,42 @@ void TcpConnection::handleWrite() {
     }
 }
 
+// 每次越过高水位只回调一次，降到低水位以下之后才会再次触发，避免在水位附近反复回调
+void TcpConnection::checkHighWaterMark(size_t pendingBytes) {
+    if (!aboveHighWater_ && pendingBytes >= highWaterMark_) {
+        aboveHighWater_ = true;
+        if (highWaterMarkCallback_) {
+            loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), pendingBytes));
+        }
+    }
+}
+
+void TcpConnection::checkLowWaterMark() {
+    size_t pendingBytes = pendingOutputBytes();
+    if (aboveHighWater_ && pendingBytes <= lowWaterMark_) {
+        aboveHighWater_ = false;
+        if (lowWaterMarkCallback_) {
+            loop_->queueInLoop(std::bind(lowWaterMarkCallback_, shared_from_this(), pendingBytes));
+        }
+        // 因为本连接越过高水位而暂停的 splice 来源连接
+        TcpConnectionPtr source = spliceSource_.lock();
+        if (source) {
+            source->onSpliceDrained();
+        }
+    }
+}
+
 void TcpConnection::handleClose() {
     LOG_DEBUG("fd = %d state = %d\n", channel_->fd(), (int)state_);
     setState(kDisconnected);
     channel_->disableAll();
 
+    // 转发中途异常断开，peer 再也等不到 EOF，一起断开
+    TcpConnectionPtr peer = spliceTarget_.lock();
+    if (peer && (!spliceReadEof_ || outputPending())) {
+        peer->forceClose();
+    }
+
     TcpConnectionPtr guardThis(shared_from_this());
     connectionCallback_(guardThis);
     closeCallback_(guardThis);
@@ -204,56 +915,171 @@ void TcpConnection::handleError() {
     LOG_ERROR("TcpConnection::handleError name:%s - SO_ERROR:%d", name_.c_str(), err);
 }
 
-// 零拷贝发送文件
+// 零拷贝发送文件，fd 需要保持打开直到文件内容发送完毕（writeCompleteCallback 被调用）
 void TcpConnection::sendFile(int fd, off_t offset, size_t count) {
     if (state_ == kConnected) {
         if (loop_->isInLoopThread()) {
             sendFileInLoop(fd, offset, count);
         } else {
-            loop_->runInLoop(std::bind(&TcpConnection::sendFileInLoop, this, fd, offset, count));
+            loop_->runInLoop(std::bind(&TcpConnection::sendFileInLoop, shared_from_this(), fd, offset, count));
         }
     } else {
         LOG_ERROR("TcpConnection::sendFile - connection is not connected");
     }
 }
 
-// 在事件循环中执行sendfile
+/**
+ * 文件作为一个特殊发送项进入输出队列，与 outputBuffer_ 中的数据按调用顺序发送
+ * 发送缓冲区写满时等待 EPOLLOUT，由 handleWrite 从上次的位置继续 sendfile，不会空转
+ */
 void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t count) {
-    off_t bytesSent = 0;    // 发送了多少字节
-    off_t remaining = count;    // 还剩多少字节要发送
-    bool faultError = false;
-
-    if (state_ == kDisconnecting) {
-        // 如果是半关闭状态，不再发送数据
+    if (state_ == kDisconnected) {
         LOG_ERROR("disconnected, give up writing");
         return;
     }
+    ++numSendCalls_;
+    if (count == 0) {
+        return;
+    }
 
-    // 如果channel_没有关注写事件(第一次发送数据)或者output buffer没有数据
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) {
-        bytesSent = ::sendfile(channel_->fd(), fd, &offset, count);
-        if (bytesSent >= 0) {
-            remaining -= bytesSent;
-            if (remaining == 0 && writeCompleteCallback_) {
-                loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
-            }
+    OutputEntry entry;
+    entry.type = OutputEntry::kFile;
+    entry.streamOffset = outputBuffer_.totalAppended();
+    entry.data = nullptr;
+    entry.zeroCopySent = false;
+    entry.len = count;
+    entry.sent = 0;
+    entry.fileFd = fd;
+    entry.fileOffset = offset;
+    outputQueue_.push_back(std::move(entry));
+    queuedBytes_ += count;
+    checkHighWaterMark();
+
+    if (!channel_->isWriting()) {
+        if (autoCork_) {
+            queueCorkedFlush();
         } else {
-            if (errno != EWOULDBLOCK) {
-                LOG_ERROR("TcpConnection::sendFileInLoop");
-                if (errno == EPIPE || errno == ECONNRESET) {
-                    faultError = true;
-                }
-            }
-            if (errno == EPIPE || errno == ECONNRESET) {    // EPIPE表示对端关闭写端，ECONNRESET表示对端重置连接
-                faultError = true;
-            }
+            flush();
         }
     }
+}
 
-    // 没写完继续发送
-    if (!faultError && remaining > 0) {
-        loop_->queueInLoop(std::bind(&TcpConnection::sendFileInLoop, shared_from_this(), fd, offset, remaining));
+void TcpConnection::spliceTo(const TcpConnectionPtr &peer) {
+    loop_->runInLoop(std::bind(&TcpConnection::spliceToInLoop, shared_from_this(), peer));
+}
+
+void TcpConnection::spliceToInLoop(const TcpConnectionPtr &peer) {
+    if (state_ != kConnected) {
+        return;
+    }
+    if (peer->getLoop() != loop_) {
+        LOG_ERROR("TcpConnection::spliceTo [%s] - peer [%s] belongs to another loop", name_.c_str(), peer->name().c_str());
+        return;
+    }
+    if (!splicePipe_) {
+        splicePipe_ = loop_->pipePool()->acquire();
+        if (!splicePipe_) {
+            return;
+        }
+    }
+    spliceTarget_ = peer;
+
+    // 进入转发模式之前已经读到但还没有被取走的数据
+    if (inputBuffer_.readableBytes() > 0) {
+        peer->send(&inputBuffer_);
+    }
+}
+
+/**
+ * socket -> 管道，每次最多读入管道剩余的容量，然后把这段数据作为发送项挂到 peer 的输出队列上
+ * 管道按页存放数据，剩余容量不足一页时 splice 也会返回 EAGAIN，同样视为管道已满
+ * 转发的数据计入 peer 的待发送字节数，peer 越过高水位时同样暂停读取，与普通连接的背压一致
+ */
+void TcpConnection::handleSpliceRead() {
+    TcpConnectionPtr peer = spliceTarget_.lock();
+    if (!peer || peer->state_ == kDisconnected) {
+        handleClose();
+        return;
+    }
+
+    PipePool::Pipe *pipe = splicePipe_.get();
+    ssize_t n = 0;
+    if (pipe->buffered < pipe->capacity) {
+        n = ::splice(channel_->fd(), nullptr, pipe->writeFd, nullptr, pipe->capacity - pipe->buffered,
+                     SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    } else {
+        n = -1;
+        errno = EAGAIN;
+    }
+
+    if (n > 0) {
+        pipe->buffered += n;
+        peer->appendSpliced(splicePipe_, n, shared_from_this());
+        if (pipe->buffered >= pipe->capacity || peer->aboveHighWater_) {
+            splicePaused_ = true;
+            channel_->disableReading();
+        }
+    } else if (n == 0) {
+        spliceReadEof_ = true;
+        channel_->disableReading();
+        peer->shutdown();
+        // 写方向已经被 peer 关闭，两个方向都结束了
+        if (state_ == kDisconnecting && !channel_->isWriting() && !outputPending()) {
+            handleClose();
+        }
+    } else if (errno == EAGAIN) {
+        // 管道为空时说明 socket 暂时没有数据，否则是管道满了，等 peer 发送后再读
+        if (pipe->buffered > 0) {
+            splicePaused_ = true;
+            channel_->disableReading();
+        }
+    } else {
+        LOG_ERROR("TcpConnection::handleSpliceRead");
+        handleError();
     }
 }
 
-}
\ No newline at end of file
+// 同一个管道中连续转发的数据合并成一个发送项
+void TcpConnection::appendSpliced(const std::shared_ptr<PipePool::Pipe> &pipe, size_t len, const TcpConnectionPtr &source) {
+    if (!outputQueue_.empty() && outputQueue_.back().type == OutputEntry::kPipe &&
+        outputQueue_.back().pipe == pipe && outputQueue_.back().streamOffset == outputBuffer_.totalAppended()) {
+        outputQueue_.back().len += len;
+    } else {
+        OutputEntry entry;
+        entry.type = OutputEntry::kPipe;
+        entry.streamOffset = outputBuffer_.totalAppended();
+        entry.data = nullptr;
+        entry.zeroCopySent = false;
+        entry.len = len;
+        entry.sent = 0;
+        entry.fileFd = -1;
+        entry.fileOffset = 0;
+        entry.pipe = pipe;
+        entry.source = source;
+        outputQueue_.push_back(std::move(entry));
+    }
+    spliceSource_ = source;
+    queuedBytes_ += len;
+    checkHighWaterMark();
+
+    if (!channel_->isWriting()) {
+        if (autoCork_) {
+            queueCorkedFlush();
+        } else {
+            flush();
+        }
+    }
+}
+
+// peer 从管道中取走了数据或者降到了低水位：管道空出一半容量、且 peer 不在高水位之上时恢复读取，避免每空出一页就唤醒一次
+void TcpConnection::onSpliceDrained() {
+    TcpConnectionPtr peer = spliceTarget_.lock();
+    if (splicePaused_ && splicePipe_->buffered <= splicePipe_->capacity / 2 && !(peer && peer->aboveHighWater_)) {
+        splicePaused_ = false;
+        if (reading_) {
+            startReadInLoop();
+        }
+    }
+}
+
+}
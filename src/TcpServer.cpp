@@ -13,6 +13,9 @@ TcpServer::TcpServer(EventLoop* loop, const InetAddress& listenAddr, const std::
       threadPool_(new EventLoopThreadPool(loop, name_)),
       connectionCallback_(),
       messageCallback_(),
+      readerIdleSeconds_(0.0),
+      writerIdleSeconds_(0.0),
+      allIdleSeconds_(0.0),
       started_(false),
       nextConnId_(1) {
     acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this, std::placeholders::_1, std::placeholders::_2));
@@ -63,6 +66,8 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr) {
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setIdleCallback(idleCallback_);
+    conn->setIdleTimeout(readerIdleSeconds_, writerIdleSeconds_, allIdleSeconds_);
 
     conn->setCloseCallback(std::bind(&TcpServer::removeConnection, this, std::placeholders::_1));
     
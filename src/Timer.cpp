@@ -4,11 +4,15 @@ namespace muduo {
 
 std::atomic<int64_t> Timer::s_numCreated_(0);
 
-void Timer::restart(TimeStamp now) {
+// 按原定的到期时间累加周期，执行延迟不会逐次累积；已经落后于 now 时跳过错过的周期
+void Timer::restart(MonoTime now) {
     if (repeat_) {
-        expiration_ = addTime(now, interval_);
+        expiration_ = addTime(expiration_, interval_);
+        if (expiration_ < now) {
+            expiration_ = addTime(now, interval_);
+        }
     } else {
-        expiration_ = TimeStamp::invalid();
+        expiration_ = MonoTime::invalid();
     }
 }
 
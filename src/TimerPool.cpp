@@ -0,0 +1,44 @@
+#include <cassert>
+
+#include "TimerPool.h"
+
+namespace muduo {
+
+const size_t TimerPool::kTimersPerChunk;
+
+TimerPool::TimerPool()
+    : freeList_(nullptr),
+      numInUse_(0) {}
+
+TimerPool::~TimerPool() {
+    assert(numInUse_ == 0);
+}
+
+Timer* TimerPool::create(TimerCallback cb, MonoTime when, double interval, int64_t sequence) {
+    if (freeList_ == nullptr) {
+        grow();
+    }
+    Slot* slot = freeList_;
+    freeList_ = slot->next;
+    ++numInUse_;
+    return new (&slot->storage) Timer(std::move(cb), when, interval, sequence);
+}
+
+void TimerPool::destroy(Timer* timer) {
+    timer->~Timer();
+    Slot* slot = reinterpret_cast<Slot*>(timer);
+    slot->next = freeList_;
+    freeList_ = slot;
+    --numInUse_;
+}
+
+void TimerPool::grow() {
+    std::unique_ptr<Slot[]> chunk(new Slot[kTimersPerChunk]);
+    for (size_t i = 0; i < kTimersPerChunk; ++i) {
+        chunk[i].next = i + 1 < kTimersPerChunk ? &chunk[i + 1] : freeList_;
+    }
+    freeList_ = &chunk[0];
+    chunks_.push_back(std::move(chunk));
+}
+
+}
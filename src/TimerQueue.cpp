@@ -16,46 +16,39 @@ int createTimerfd() {
     return timerfd;
 }
 
-// 计算距离when还有多长时间(单位:ns)
-struct timespec howMuchTimeFromNow(TimeStamp when) {
-    int64_t microseconds = when.microSecondsSinceEpoch() - TimeStamp::now().microSecondsSinceEpoch();
-    if (microseconds < 100) {
-        microseconds = 100;
-    }
-    struct timespec ts;
-    ts.tv_sec = static_cast<time_t>(microseconds / TimeStamp::kMicroSecondsPerSecond);
-    ts.tv_nsec = static_cast<long>((microseconds % TimeStamp::kMicroSecondsPerSecond) * 1000);
-    return ts;
-}
-
 // 响应定时器到期事件，重置timerfd的可读事件，以便下一次到期事件
-void readTimerfd(int timerfd, TimeStamp now) {
+void readTimerfd(int timerfd) {
     uint64_t howmany;   // 读取到期次数
     ssize_t n = ::read(timerfd, &howmany, sizeof(howmany));  // 读取timerfd，以清除可读事件
-    LOG_DEBUG_S << "TimerQueue::handleRead() " << howmany << " at " << now.toString();
+    LOG_DEBUG_S << "TimerQueue::handleRead() " << howmany;
     if (n != sizeof(howmany)) {
         LOG_ERROR_S << "TimerQueue::handleRead() reads " << n << " bytes instead of 8";
     }    
 }
 
-// 重置timerfd的到期时间，使用timerfd_settime函数
-void resetTimerfd(int timerfd, TimeStamp expiration) {
+// 按单调时钟上的绝对时间设置timerfd的到期时间，不需要先读取当前时间，也没有最小间隔的限制
+void resetTimerfd(int timerfd, MonoTime expiration) {
     struct itimerspec newValue;
-    struct itimerspec oldValue;
     memset(&newValue, 0, sizeof(newValue));
-    memset(&oldValue, 0, sizeof(oldValue));
-    newValue.it_value = howMuchTimeFromNow(expiration);
-    int ret = ::timerfd_settime(timerfd, 0, &newValue, &oldValue);
+    newValue.it_value.tv_sec = static_cast<time_t>(expiration.nanoSeconds() / MonoTime::kNanoSecondsPerSecond);
+    newValue.it_value.tv_nsec = static_cast<long>(expiration.nanoSeconds() % MonoTime::kNanoSecondsPerSecond);
+    int ret = ::timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &newValue, nullptr);
     if (ret) {
         LOG_ERROR_S << "timerfd_settime()";
     }
 }
 
+const int64_t TimerQueue::kDefaultTickNanoSeconds;
+const int64_t TimerQueue::kShortWaitNanoSeconds;
+
 TimerQueue::TimerQueue(EventLoop* loop) 
     : loop_(loop),
       timerfd_(createTimerfd()),
       timerfdChannel_(loop, timerfd_),
-      timers_(),
+      wheel_(kDefaultTickNanoSeconds, MonoTime::now()),
+      nextDirty_(false),
+      numRearmsRequested_(0),
+      numRearmsIssued_(0),
       callingExpiredTimers_(false) {
     timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
     timerfdChannel_.enableReading();
@@ -65,125 +58,155 @@ TimerQueue::~TimerQueue() {
     timerfdChannel_.disableAll();
     timerfdChannel_.remove();
     ::close(timerfd_);
-    for (const Entry& timer : timers_) {
-        delete timer.second;
+    std::vector<Timer*> timers;
+    wheel_.takeAll(&timers);
+    for (Timer* timer : timers) {
+        pool_.destroy(timer);
     }
 }
 
-TimerId TimerQueue::addTimer(TimerCallback cb, TimeStamp when, double interval) {
-    Timer* timer = new Timer(std::move(cb), when, interval);
-    loop_->runInLoop(std::bind(&TimerQueue::addTimerInLoop, this, timer));
-    return TimerId(timer, timer->sequence());
+TimerId TimerQueue::addTimer(TimerCallback cb, MonoTime when, double interval) {
+    const int64_t sequence = Timer::newSequence();
+    // 跨线程添加/取消定时器走优先队列，不会排在突发的普通任务后面而错过到期时间
+    // Timer 总是在 IO 线程中从对象池创建；跨线程时回调连同参数放不进 Task 的内联空间，仍有一次堆分配
+    if (loop_->isInLoopThread()) {
+        addTimerInLoop(pool_.create(std::move(cb), when, interval, sequence));
+    } else {
+        loop_->queueUrgentInLoop(std::bind(&TimerQueue::createTimerInLoop, this, std::move(cb), when, interval, sequence));
+    }
+    return TimerId(sequence);
 }
 
 void TimerQueue::cancel(TimerId timerId) {
-    loop_->runInLoop(std::bind(&TimerQueue::cancelInLoop, this, timerId));
+    if (loop_->isInLoopThread()) {
+        cancelInLoop(timerId);
+    } else {
+        loop_->queueUrgentInLoop(std::bind(&TimerQueue::cancelInLoop, this, timerId));
+    }
+}
+
+void TimerQueue::setResolution(double seconds) {
+    loop_->assertInLoopThread();
+    int64_t tickNs = static_cast<int64_t>(seconds * MonoTime::kNanoSecondsPerSecond);
+    wheel_.setTickNanoSeconds(tickNs, MonoTime::now());
+    armedExpiration_ = MonoTime::invalid();
+    nextDirty_ = true;
+}
+
+double TimerQueue::resolution() const {
+    return static_cast<double>(wheel_.tickNanoSeconds()) / MonoTime::kNanoSecondsPerSecond;
+}
+
+void TimerQueue::createTimerInLoop(TimerCallback& cb, MonoTime when, double interval, int64_t sequence) {
+    addTimerInLoop(pool_.create(std::move(cb), when, interval, sequence));
 }
 
 void TimerQueue::addTimerInLoop(Timer* timer) {
     loop_->assertInLoopThread();
-    bool earliestChanged = insert(timer);
-    if (earliestChanged) {
-        resetTimerfd(timerfd_, timer->expiration());
+    insert(timer);
+    // 比 timerfd 已设置的时间早才需要重新设置，留到本轮结束时合并为一次
+    if (!armedExpiration_.valid() || timer->expiration() < armedExpiration_) {
+        numRearmsRequested_.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
 void TimerQueue::cancelInLoop(TimerId timerId) {
     loop_->assertInLoopThread();
-    ActiveTimer timer(timerId.timer_, timerId.sequence_);
-    auto it = activeTimers_.find(timer);
+    auto it = activeTimers_.find(timerId.sequence_);
     if (it != activeTimers_.end()) {
-        size_t n = timers_.erase(Entry(it->first->expiration(), it->first));
-        assert(n == 1);
-        delete it->first;
+        wheel_.remove(it->second);
+        pool_.destroy(it->second);
         activeTimers_.erase(it);
+        nextDirty_ = true;
     } else if (callingExpiredTimers_) {
-        cancelingTimers_.insert(timer);
+        // 正在执行的重复定时器，执行完后不再加入
+        cancelingTimers_.insert(timerId.sequence_);
     }
 
-    assert(timers_.size() == activeTimers_.size());
+    assert(wheel_.size() == activeTimers_.size());
 }
 
 // 定时器到期事件处理函数
 void TimerQueue::handleRead() {
     loop_->assertInLoopThread();
 
-    TimeStamp now(TimeStamp::now());
-    readTimerfd(timerfd_, now);
+    readTimerfd(timerfd_);
+    armedExpiration_ = MonoTime::invalid();
+    expireTimers(MonoTime::now());
+}
+
+void TimerQueue::expireTimers(MonoTime now) {
+    loop_->assertInLoopThread();
+
+    // 获取到期的定时器
+    expired_.clear();
+    wheel_.advance(now, &expired_);
+    nextDirty_ = true;
+    if (expired_.empty()) {
+        return;
+    }
+    for (Timer* timer : expired_) {
+        size_t n = activeTimers_.erase(timer->sequence());
+        assert(n == 1);
+        (void)n;
+    }
+    assert(wheel_.size() == activeTimers_.size());
 
-    std::vector<Entry> expired = getExpired(now);   // 获取到期的定时器
     callingExpiredTimers_ = true;
     cancelingTimers_.clear();
-    for (const Entry& entry : expired) {
-        entry.second->run();
+    for (Timer* timer : expired_) {
+        timer->run();
     }
     callingExpiredTimers_ = false;
 
-    reset(expired, now);
-}
-
-// 获取到期的定时器
-std::vector<TimerQueue::Entry> TimerQueue::getExpired(TimeStamp now) {
-    std::vector<Entry> expired;
-    Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));   // UINTPTR_MAX：uintptr_t的最大值，这里用于构造一个合法的sentry
-    TimerList::iterator end = timers_.lower_bound(sentry);  // 返回第一个未到期的定时器
-    assert(end == timers_.end() || now < end->first);
-    std::copy(timers_.begin(), end, back_inserter(expired));    // 将到期的定时器加入expired
-    timers_.erase(timers_.begin(), end);
-    for (const Entry& entry : expired) {
-        ActiveTimer timer(entry.second, entry.second->sequence());
-        size_t n = activeTimers_.erase(timer);
-        assert(n == 1);
-    }
-    assert(timers_.size() == activeTimers_.size());
-    return expired;
+    reset(expired_, now);
 }
 
 // 重置到期的定时器(重复定时器重新加入，非重复定时器删除)
-void TimerQueue::reset(const std::vector<Entry>& expired, TimeStamp now) {
-    TimeStamp nextExpire;
-    for (const Entry& entry : expired) {
-        ActiveTimer timer(entry.second, entry.second->sequence());
-        if (entry.second->repeat() && cancelingTimers_.find(timer) == cancelingTimers_.end()) {
-            entry.second->restart(now);
-            insert(entry.second);
+void TimerQueue::reset(const std::vector<Timer*>& expired, MonoTime now) {
+    for (Timer* timer : expired) {
+        if (timer->repeat() && cancelingTimers_.find(timer->sequence()) == cancelingTimers_.end()) {
+            timer->restart(now);
+            insert(timer);
         } else {
-            delete entry.second;
+            pool_.destroy(timer);
         }
     }
 
-    if (!timers_.empty()) { // 有定时器，重置timerfd的到期时间
-        nextExpire = timers_.begin()->second->expiration();
-    }
-
-    if (nextExpire.valid()) {
-        resetTimerfd(timerfd_, nextExpire);
-    }
+    numRearmsRequested_.fetch_add(1, std::memory_order_relaxed);
 }
 
 // 插入定时器
-bool TimerQueue::insert(Timer* timer) {
+void TimerQueue::insert(Timer* timer) {
     loop_->assertInLoopThread();
-    assert(timers_.size() == activeTimers_.size());
-    bool earliestChanged = false;   // 是否最早到期时间改变
-    TimeStamp when = timer->expiration();
-    TimerList::iterator it = timers_.begin();
-    if (it == timers_.end() || when < it->first) {
-        earliestChanged = true;
-    }
+    wheel_.insert(timer);
+    std::pair<std::unordered_map<int64_t, Timer*>::iterator, bool> result =
+        activeTimers_.insert(std::make_pair(timer->sequence(), timer));
+    assert(result.second);
+    nextDirty_ = true;
+    (void)result;
+    assert(wheel_.size() == activeTimers_.size());
+}
 
-    {
-        std::pair<TimerList::iterator, bool> result = timers_.insert(Entry(when, timer));
-        assert(result.second);
+int64_t TimerQueue::prepareWait(MonoTime now, bool preciseWait) {
+    if (nextDirty_) {
+        nextExpiration_ = wheel_.nextExpiration();
+        nextDirty_ = false;
     }
-
-    {
-        std::pair<ActiveTimerSet::iterator, bool> result = activeTimers_.insert(ActiveTimer(timer, timer->sequence()));
-        assert(result.second);
+    if (!nextExpiration_.valid()) {
+        return -1;
     }
-
-    assert(timers_.size() == activeTimers_.size());
-    return earliestChanged;
+    int64_t waitNs = nextExpiration_.nanoSeconds() - now.nanoSeconds();
+    if (preciseWait && waitNs < kShortWaitNanoSeconds) {
+        return waitNs > 0 ? waitNs : 0;
+    }
+    // 时间轮的下一次处理时间早于 timerfd 已设置的时间时，重新设置 timerfd
+    if (!armedExpiration_.valid() || nextExpiration_ < armedExpiration_) {
+        numRearmsIssued_.fetch_add(1, std::memory_order_relaxed);
+        resetTimerfd(timerfd_, nextExpiration_);
+        armedExpiration_ = nextExpiration_;
+    }
+    return -1;
 }
 
-}
\ No newline at end of file
+}
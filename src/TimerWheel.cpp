@@ -0,0 +1,219 @@
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+
+#include "TimerWheel.h"
+
+namespace muduo {
+
+namespace {
+
+// 在位图的 [begin, end) 中查找第一个置位的下标，没有返回 -1
+int firstSet(const uint64_t* bits, int begin, int end) {
+    for (int i = begin; i < end; ) {
+        int word = i >> 6;
+        uint64_t w = bits[word] >> (i & 63);
+        if (w != 0) {
+            int index = i + __builtin_ctzll(w);
+            return index < end ? index : -1;
+        }
+        i = (word + 1) << 6;
+    }
+    return -1;
+}
+
+}
+
+const int TimerWheel::kNumLevels;
+const int TimerWheel::kLevel0Bits;
+const int TimerWheel::kLevelBits;
+
+TimerWheel::TimerWheel(int64_t tickNanoSeconds, MonoTime now)
+    : tickNs_(std::max<int64_t>(tickNanoSeconds, 1)),
+      currentTick_(now.nanoSeconds() / tickNs_),
+      size_(0) {
+    for (int level = 0; level < kNumLevels; ++level) {
+        slots_[level].assign(levelSlots(level), nullptr);
+    }
+    ::memset(occupied_, 0, sizeof(occupied_));
+}
+
+int64_t TimerWheel::expirationTick(const Timer* timer) const {
+    return (timer->expiration().nanoSeconds() + tickNs_ - 1) / tickNs_;
+}
+
+void TimerWheel::insert(Timer* timer) {
+    // 当前 tick 已经处理过，已到期的定时器放到下一个 tick
+    insertAt(timer, currentTick_ + 1);
+    ++size_;
+}
+
+void TimerWheel::insertAt(Timer* timer, int64_t minTick) {
+    int64_t tick = std::max(expirationTick(timer), minTick);
+    int64_t delta = tick - currentTick_;
+    for (int level = 0; level < kNumLevels; ++level) {
+        int shift = levelShift(level);
+        int bits = level == 0 ? kLevel0Bits : kLevelBits;
+        if (delta < (int64_t(1) << (shift + bits))) {
+            link(timer, level, static_cast<int>((tick >> shift) & (levelSlots(level) - 1)));
+            return;
+        }
+    }
+    // 超出最高层的范围，先放在最远的槽中，下移时再按实际到期时间插入
+    const int top = kNumLevels - 1;
+    int64_t farthest = currentTick_ + (int64_t(1) << (levelShift(top) + kLevelBits)) - 1;
+    link(timer, top, static_cast<int>((farthest >> levelShift(top)) & (levelSlots(top) - 1)));
+}
+
+void TimerWheel::remove(Timer* timer) {
+    assert(timer->level_ >= 0);
+    unlink(timer);
+    --size_;
+}
+
+void TimerWheel::link(Timer* timer, int level, int slot) {
+    Timer*& head = slots_[level][slot];
+    timer->prev_ = nullptr;
+    timer->next_ = head;
+    if (head != nullptr) {
+        head->prev_ = timer;
+    }
+    head = timer;
+    timer->level_ = level;
+    timer->slot_ = slot;
+    occupied_[level][slot >> 6] |= uint64_t(1) << (slot & 63);
+}
+
+void TimerWheel::unlink(Timer* timer) {
+    int level = timer->level_;
+    int slot = timer->slot_;
+    if (timer->prev_ != nullptr) {
+        timer->prev_->next_ = timer->next_;
+    } else {
+        slots_[level][slot] = timer->next_;
+    }
+    if (timer->next_ != nullptr) {
+        timer->next_->prev_ = timer->prev_;
+    }
+    if (slots_[level][slot] == nullptr) {
+        occupied_[level][slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+    }
+    timer->prev_ = timer->next_ = nullptr;
+    timer->level_ = timer->slot_ = -1;
+}
+
+// 取下整个槽的链表并清空位图
+Timer* TimerWheel::detachSlot(int level, int slot) {
+    Timer* head = slots_[level][slot];
+    slots_[level][slot] = nullptr;
+    occupied_[level][slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+    return head;
+}
+
+void TimerWheel::cascade(int level, int64_t tick) {
+    int slot = static_cast<int>((tick >> levelShift(level)) & (levelSlots(level) - 1));
+    Timer* timer = detachSlot(level, slot);
+    while (timer != nullptr) {
+        Timer* next = timer->next_;
+        // 此时 currentTick_ 对应的第 0 层槽还没有处理，恰好在这个 tick 到期的定时器放入其中
+        insertAt(timer, currentTick_);
+        timer = next;
+    }
+}
+
+void TimerWheel::advance(MonoTime now, std::vector<Timer*>* expired) {
+    const int64_t nowTick = now.nanoSeconds() / tickNs_;
+    const int64_t level0Mask = levelSlots(0) - 1;
+    while (currentTick_ < nowTick) {
+        // 中间的空槽和没有定时器的下移边界都直接跳过
+        int64_t next = nextEventTick();
+        if (next > nowTick) {
+            currentTick_ = nowTick;
+            break;
+        }
+        currentTick_ = next;
+
+        if ((next & level0Mask) == 0) {
+            for (int level = kNumLevels - 1; level >= 1; --level) {
+                if ((next & ((int64_t(1) << levelShift(level)) - 1)) == 0) {
+                    cascade(level, next);
+                }
+            }
+        }
+
+        Timer* timer = detachSlot(0, static_cast<int>(next & level0Mask));
+        while (timer != nullptr) {
+            Timer* following = timer->next_;
+            timer->prev_ = timer->next_ = nullptr;
+            timer->level_ = timer->slot_ = -1;
+            expired->push_back(timer);
+            --size_;
+            timer = following;
+        }
+    }
+}
+
+int64_t TimerWheel::nextEventTick() const {
+    if (size_ == 0) {
+        return INT64_MAX;
+    }
+    int64_t best = INT64_MAX;
+    const int64_t level0Mask = levelSlots(0) - 1;
+    int offset = findOccupied(0, static_cast<int>((currentTick_ + 1) & level0Mask));
+    if (offset >= 0) {
+        best = currentTick_ + 1 + offset;
+    }
+    // 上层的槽在其所在的一圈开始时下移，这之后才可能在第 0 层到期
+    for (int level = 1; level < kNumLevels; ++level) {
+        int shift = levelShift(level);
+        int64_t group = (currentTick_ >> shift) + 1;
+        offset = findOccupied(level, static_cast<int>(group & (levelSlots(level) - 1)));
+        if (offset >= 0) {
+            best = std::min(best, (group + offset) << shift);
+        }
+    }
+    return best;
+}
+
+MonoTime TimerWheel::nextExpiration() const {
+    int64_t tick = nextEventTick();
+    return tick == INT64_MAX ? MonoTime::invalid() : MonoTime(tick * tickNs_);
+}
+
+int TimerWheel::findOccupied(int level, int from) const {
+    int n = levelSlots(level);
+    int index = firstSet(occupied_[level], from, n);
+    if (index >= 0) {
+        return index - from;
+    }
+    index = firstSet(occupied_[level], 0, from);
+    return index >= 0 ? index + n - from : -1;
+}
+
+void TimerWheel::takeAll(std::vector<Timer*>* timers) {
+    for (int level = 0; level < kNumLevels; ++level) {
+        for (int slot = 0; slot < levelSlots(level); ++slot) {
+            Timer* timer = detachSlot(level, slot);
+            while (timer != nullptr) {
+                Timer* next = timer->next_;
+                timer->prev_ = timer->next_ = nullptr;
+                timer->level_ = timer->slot_ = -1;
+                timers->push_back(timer);
+                timer = next;
+            }
+        }
+    }
+    size_ = 0;
+}
+
+void TimerWheel::setTickNanoSeconds(int64_t tickNanoSeconds, MonoTime now) {
+    std::vector<Timer*> timers;
+    takeAll(&timers);
+    tickNs_ = std::max<int64_t>(tickNanoSeconds, 1);
+    currentTick_ = now.nanoSeconds() / tickNs_;
+    for (Timer* timer : timers) {
+        insert(timer);
+    }
+}
+
+}
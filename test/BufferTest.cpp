@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <string>
+
+#include "Buffer.h"
+
+using namespace muduo;
+
+// 大数据量连续到达时，预留空间逐步放大，之后不再溢出到栈上的额外空间
+TEST(BufferTest, ReadFdAdaptsToLargeReads) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(fds[1], F_SETPIPE_SZ, 256 * 1024);
+
+    Buffer buf;
+    std::string chunk(200 * 1024, 'a');
+    int savedErrno = 0;
+    for (int round = 0; round < 10; ++round) {
+        size_t written = 0;
+        while (written < chunk.size()) {
+            ssize_t n = ::write(fds[1], chunk.data() + written, chunk.size() - written);
+            ASSERT_GT(n, 0);
+            written += n;
+            while (buf.readFd(fds[0], &savedErrno) > 0) {
+            }
+        }
+        EXPECT_EQ(buf.retrieveAllAsString(), chunk);
+    }
+
+    EXPECT_GT(buf.readSizeHint(), 64u * 1024);
+    EXPECT_LE(buf.numOverflowReads(), 2u);
+    EXPECT_LT(buf.numOverflowReads() * 10, buf.numReads());
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// 流量变小后预留空间逐步缩小
+TEST(BufferTest, ReadFdShrinksHintForSmallReads) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    Buffer buf;
+    std::string big(64 * 1024, 'b');
+    ASSERT_EQ(::write(fds[1], big.data(), big.size()), static_cast<ssize_t>(big.size()));
+    int savedErrno = 0;
+    while (buf.readFd(fds[0], &savedErrno) > 0) {
+    }
+    buf.retrieveAll();
+    size_t grown = buf.readSizeHint();
+    EXPECT_GT(grown, Buffer::kInitialSize);
+
+    for (int i = 0; i < 64; ++i) {
+        ASSERT_EQ(::write(fds[1], "hello", 5), 5);
+        ASSERT_EQ(buf.readFd(fds[0], &savedErrno), 5);
+        buf.retrieveAll();
+    }
+    EXPECT_EQ(buf.readSizeHint(), Buffer::kInitialSize);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// 零拷贝取出：返回的视图直接指向 Buffer 内部，读指针随之前移
+TEST(BufferTest, RetrieveAsPiece) {
+    Buffer buf;
+    buf.append("hello world", 11);
+
+    const char* base = buf.peek();
+    StringPiece hello = buf.retrieveAsPiece(5);
+    EXPECT_EQ(hello.data(), base);
+    EXPECT_EQ(hello, StringPiece("hello"));
+    EXPECT_EQ(buf.readableBytes(), 6u);
+
+    StringPiece rest = buf.retrieveAllAsPiece();
+    EXPECT_EQ(rest, StringPiece(" world"));
+    EXPECT_EQ(buf.readableBytes(), 0u);
+
+    EXPECT_EQ(buf.retrieveAsPiece(100).size(), 0u);
+}
+
+// 整数按网络字节序读写
+TEST(BufferTest, IntegersInNetworkByteOrder) {
+    Buffer buf;
+    buf.appendInt64(0x0102030405060708LL);
+    buf.appendInt32(-2);
+    buf.appendInt16(0x0a0b);
+    buf.appendInt8(-1);
+    ASSERT_EQ(buf.readableBytes(), 15u);
+
+    const unsigned char kExpected[] = {1, 2, 3, 4, 5, 6, 7, 8, 0xff, 0xff, 0xff, 0xfe, 0x0a, 0x0b, 0xff};
+    EXPECT_EQ(::memcmp(buf.peek(), kExpected, sizeof kExpected), 0);
+
+    EXPECT_EQ(buf.peekInt64(), 0x0102030405060708LL);
+    EXPECT_EQ(buf.readInt64(), 0x0102030405060708LL);
+    EXPECT_EQ(buf.readInt32(), -2);
+    EXPECT_EQ(buf.readInt16(), 0x0a0b);
+    EXPECT_EQ(buf.readInt8(), -1);
+    EXPECT_EQ(buf.readableBytes(), 0u);
+}
+
+// 先写消息体再用前部预留空间补写长度头，消息体不移动
+TEST(BufferTest, PrependLengthHeader) {
+    Buffer buf;
+    EXPECT_EQ(buf.prependableBytes(), Buffer::kCheapPrepend);
+
+    buf.append(StringPiece("payload"));
+    const char* body = buf.peek();
+    buf.prependInt32(static_cast<int32_t>(buf.readableBytes()));
+    EXPECT_EQ(buf.prependableBytes(), Buffer::kCheapPrepend - sizeof(int32_t));
+    EXPECT_EQ(buf.peek() + sizeof(int32_t), body);
+
+    EXPECT_EQ(buf.readInt32(), 7);
+    EXPECT_EQ(buf.retrieveAllAsString(), "payload");
+
+    buf.append("x", 1);
+    buf.prependInt64(42);
+    EXPECT_EQ(buf.prependableBytes(), 0u);
+    EXPECT_EQ(buf.readInt64(), 42);
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ByteScanner.h"
+#include "Buffer.h"
+#include "Logger.h"
+
+using namespace muduo;
+using namespace std::chrono;
+
+namespace {
+
+std::vector<const ByteScanner*> availableScanners() {
+    std::vector<const ByteScanner*> scanners;
+    for (ByteScanner::Level level : {ByteScanner::kScalar, ByteScanner::kSSE2, ByteScanner::kAVX2}) {
+        const ByteScanner* s = ByteScanner::get(level);
+        if (s) {
+            scanners.push_back(s);
+        }
+    }
+    return scanners;
+}
+
+const char* refFindCRLF(const char* begin, const char* end) {
+    static const char kCRLF[] = "\r\n";
+    const char* p = std::search(begin, end, kCRLF, kCRLF + 2);
+    return p == end ? nullptr : p;
+}
+
+const char* refFindAnyOf(const char* begin, const char* end, const std::string& set) {
+    const char* p = std::find_first_of(begin, end, set.begin(), set.end());
+    return p == end ? nullptr : p;
+}
+
+}
+
+// 各指令集实现与参考实现逐一比对：不同长度、不同对齐、分隔符落在每个位置（包括跨 SIMD 块边界）
+TEST(ByteScannerTest, MatchesReference) {
+    std::mt19937 rng(12345);
+    std::string data(512, 'a');
+    for (char& c : data) {
+        c = static_cast<char>('a' + rng() % 26);
+    }
+
+    for (const ByteScanner* s : availableScanners()) {
+        SCOPED_TRACE(s->name);
+        for (size_t offset = 0; offset < 4; ++offset) {
+            for (size_t len = 0; len < 140; ++len) {
+                for (size_t pos = 0; pos <= len; ++pos) {
+                    std::string buf = data.substr(0, offset + len);
+                    if (pos < len) {
+                        buf[offset + pos] = '\r';
+                        if (pos + 1 < len) {
+                            buf[offset + pos + 1] = '\n';
+                        }
+                    }
+                    const char* begin = buf.data() + offset;
+                    const char* end = begin + len;
+
+                    const char* expected = pos < len ? begin + pos : nullptr;
+                    ASSERT_EQ(s->findByte(begin, end, '\r'), expected);
+                    ASSERT_EQ(s->findCRLF(begin, end), refFindCRLF(begin, end));
+                    ASSERT_EQ(s->findAnyOf(begin, end, "\n\r", 2), refFindAnyOf(begin, end, "\n\r"));
+                }
+            }
+        }
+
+        // 只有 '\r' 没有 '\n' 不算 CRLF
+        std::string lonelyCR(100, 'x');
+        lonelyCR[31] = '\r';
+        lonelyCR[63] = '\n';
+        EXPECT_EQ(s->findCRLF(lonelyCR.data(), lonelyCR.data() + lonelyCR.size()), nullptr);
+
+        // 超过 SIMD 处理上限的大字节集合
+        std::string bigSet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        std::string text = std::string(70, 'z') + "Q";
+        EXPECT_EQ(s->findAnyOf(text.data(), text.data() + text.size(), bigSet.data(), bigSet.size()),
+                  text.data() + 70);
+        EXPECT_EQ(s->findAnyOf(text.data(), text.data() + text.size(), "", 0), nullptr);
+    }
+}
+
+TEST(ByteScannerTest, BufferHelpers) {
+    Buffer buf;
+    const char kRequest[] = "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n";
+    buf.append(kRequest, sizeof(kRequest) - 1);
+
+    const char* crlf = buf.findCRLF();
+    ASSERT_NE(crlf, nullptr);
+    EXPECT_EQ(std::string(buf.peek(), crlf), "GET / HTTP/1.1");
+
+    const char* next = buf.findCRLF(crlf + 2);
+    ASSERT_NE(next, nullptr);
+    EXPECT_EQ(std::string(crlf + 2, next), "Host: example.com");
+
+    EXPECT_EQ(buf.findEOL(), crlf + 1);
+    EXPECT_EQ(buf.findByte(':'), buf.peek() + 20);
+    EXPECT_EQ(buf.findAnyOf(" :"), buf.peek() + 3);
+
+    buf.retrieveUntil(crlf + 2);
+    EXPECT_EQ(buf.findByte('G'), nullptr);
+    EXPECT_EQ(std::string(buf.peek(), 4), "Host");
+}
+
+// 与 memchr/std::search/std::find_first_of 对比吞吐量
+// 1. 在 1MB 的数据中查找位于末尾的分隔符（长数据）
+// 2. 逐行查找类似 HTTP 头部的短行中的 CRLF（解析头部时的典型情况）
+TEST(ByteScannerTest, Benchmark) {
+    const size_t kSize = 1024 * 1024;
+    const int kRounds = 64;
+    std::string data(kSize, 'x');
+    data[kSize - 2] = '\r';
+    data[kSize - 1] = '\n';
+    const char* begin = data.data();
+    const char* end = begin + data.size();
+    const char* expected = end - 2;
+
+    auto measure = [&](const char* what, const char* impl, std::function<const char*()> fn) {
+        auto start = steady_clock::now();
+        for (int i = 0; i < kRounds; ++i) {
+            const char* p = fn();
+            ASSERT_EQ(p, expected);
+        }
+        double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+        LOG_INFO("ByteScanner %s [%s]: %.2f GB/s", what, impl, kSize * kRounds / seconds / 1e9);
+    };
+
+    measure("findByte", "memchr", [&]() { return static_cast<const char*>(::memchr(begin, '\r', kSize)); });
+    measure("findCRLF", "std::search", [&]() { return refFindCRLF(begin, end); });
+    measure("findAnyOf", "std::find_first_of", [&]() { return refFindAnyOf(begin, end, "\r\n"); });
+    for (const ByteScanner* s : availableScanners()) {
+        measure("findByte", s->name, [&]() { return s->findByte(begin, end, '\r'); });
+        measure("findCRLF", s->name, [&]() { return s->findCRLF(begin, end); });
+        measure("findAnyOf", s->name, [&]() { return s->findAnyOf(begin, end, "\r\n", 2); });
+    }
+
+    std::string headers;
+    while (headers.size() < kSize) {
+        headers += "X-Forwarded-For: 203.0.113.195, 70.41.3.18\r\n";
+    }
+    const char* hbegin = headers.data();
+    const char* hend = hbegin + headers.size();
+    size_t expectedLines = headers.size() / 44;
+
+    auto measureLines = [&](const char* impl, std::function<const char*(const char*)> fn) {
+        auto start = steady_clock::now();
+        for (int i = 0; i < kRounds / 4; ++i) {
+            size_t lines = 0;
+            for (const char* p = fn(hbegin); p != nullptr; p = fn(p + 2)) {
+                ++lines;
+            }
+            ASSERT_EQ(lines, expectedLines);
+        }
+        double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+        LOG_INFO("ByteScanner findCRLF per line [%s]: %.2f GB/s", impl, headers.size() * (kRounds / 4) / seconds / 1e9);
+    };
+
+    measureLines("std::search", [&](const char* p) { return refFindCRLF(p, hend); });
+    for (const ByteScanner* s : availableScanners()) {
+        measureLines(s->name, [&](const char* p) { return s->findCRLF(p, hend); });
+    }
+    LOG_INFO("ByteScanner best implementation: %s", ByteScanner::best().name);
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+
+#include "ChainBuffer.h"
+
+using namespace muduo;
+
+// 追加跨越多个内存块的数据后按顺序取回
+TEST(ChainBufferTest, AppendAcrossBlocks) {
+    auto pool = std::make_shared<BufferPool>(64);
+    ChainBuffer buf(pool);
+
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data.push_back(static_cast<char>('a' + i % 26));
+    }
+    buf.append(data.data(), 100);
+    buf.append(data.data() + 100, data.size() - 100);
+
+    EXPECT_EQ(buf.readableBytes(), data.size());
+    EXPECT_EQ(buf.contiguousBytes(), 64u);
+    EXPECT_EQ(buf.numBlocks(), (data.size() + 63) / 64);
+
+    EXPECT_EQ(buf.retrieveAsString(10), data.substr(0, 10));
+    buf.retrieve(100);
+    EXPECT_EQ(buf.retrieveAllAsString(), data.substr(110));
+    EXPECT_EQ(buf.readableBytes(), 0u);
+    EXPECT_EQ(buf.numBlocks(), 0u);     // 取空后内存块全部归还
+    EXPECT_EQ(pool->bytesInUse(), 0u);
+}
+
+// readFd/writeFd 通过管道收发，验证数据完整
+TEST(ChainBufferTest, ReadWriteFd) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    auto pool = std::make_shared<BufferPool>(128);
+    ChainBuffer out(pool);
+    ChainBuffer in(pool);
+
+    std::string data(1000, 'x');
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i % 251);
+    }
+    out.append(data.data(), data.size());
+
+    int savedErrno = 0;
+    ssize_t n = out.writeFd(fds[1], &savedErrno);
+    ASSERT_EQ(n, static_cast<ssize_t>(data.size()));
+    out.retrieve(n);
+
+    size_t total = 0;
+    while (total < data.size()) {
+        n = in.readFd(fds[0], &savedErrno);
+        ASSERT_GT(n, 0);
+        total += n;
+    }
+    EXPECT_EQ(in.retrieveAllAsString(), data);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// 小的读取只向内存池申请实际需要的内存块
+TEST(ChainBufferTest, SmallReadUsesOneBlock) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    auto pool = std::make_shared<BufferPool>(1024);
+    ChainBuffer in(pool);
+
+    std::string data(100, 'r');
+    ASSERT_EQ(::write(fds[1], data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    int savedErrno = 0;
+    EXPECT_EQ(in.readFd(fds[0], &savedErrno), static_cast<ssize_t>(data.size()));
+    EXPECT_EQ(in.numBlocks(), 1u);
+    EXPECT_EQ(pool->peakBytesInUse(), 1024u);
+    EXPECT_EQ(in.retrieveAllAsString(), data);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// 内存池的用量统计与内存上限
+TEST(ChainBufferTest, PoolAccountingAndCap) {
+    auto pool = std::make_shared<BufferPool>(64);
+    pool->setMaxBytes(64 * 4);
+    ChainBuffer buf(pool);
+
+    std::string data(64 * 3, 'y');
+    EXPECT_TRUE(buf.append(data.data(), data.size()));
+    EXPECT_EQ(pool->bytesInUse(), 64u * 3);
+
+    // 超过上限时什么都不追加
+    EXPECT_FALSE(buf.append(data.data(), data.size()));
+    EXPECT_EQ(buf.readableBytes(), data.size());
+    EXPECT_EQ(pool->bytesInUse(), 64u * 3);
+    EXPECT_EQ(pool->numAllocFailures(), 1u);
+
+    EXPECT_TRUE(buf.append(data.data(), 64));
+    EXPECT_EQ(pool->peakBytesInUse(), 64u * 4);
+
+    buf.retrieveAll();
+    EXPECT_EQ(pool->bytesInUse(), 0u);
+    EXPECT_EQ(pool->bytesCached(), 64u * 4);
+    EXPECT_EQ(pool->peakBytesInUse(), 64u * 4);
+}
+
+// trim 只释放一整个周期都没被用到的空闲内存块
+TEST(ChainBufferTest, PoolTrimIdleBlocks) {
+    auto pool = std::make_shared<BufferPool>(64);
+    {
+        ChainBuffer buf(pool);
+        std::string data(64 * 4, 'z');
+        buf.append(data.data(), data.size());
+    }
+    EXPECT_EQ(pool->bytesCached(), 64u * 4);
+
+    pool->trim();   // 第一个周期内缓存一直是满的，这里开始记录
+    {
+        ChainBuffer buf(pool);
+        buf.append("abc", 3);   // 用掉一个内存块后归还
+    }
+    pool->trim();   // 有 3 个内存块整个周期都没被用到
+    EXPECT_EQ(pool->bytesCached(), 64u);
+    pool->trim();
+    EXPECT_EQ(pool->bytesCached(), 0u);
+}
+
+// 多个 EventLoop 的内存池并发分配时，合计用量不超过全局上限
+TEST(ChainBufferTest, GlobalCapUnderConcurrency) {
+    const int kThreads = 4;
+    const size_t kBlocks = 1000;
+    BufferPool::setGlobalMaxBytes(BufferPool::globalBytesInUse() + 64 * kBlocks);
+
+    std::vector<std::shared_ptr<BufferPool>> pools;
+    std::vector<std::vector<char*>> blocks(kThreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        pools.push_back(std::make_shared<BufferPool>(64));
+    }
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&, i]() {
+            for (size_t j = 0; j < kBlocks; ++j) {
+                char* block = pools[i]->allocate();
+                if (block != nullptr) {
+                    blocks[i].push_back(block);
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < kThreads; ++i) {
+        total += blocks[i].size();
+        EXPECT_EQ(pools[i]->bytesInUse(), 64 * blocks[i].size());
+    }
+    EXPECT_EQ(total, kBlocks);
+    for (int i = 0; i < kThreads; ++i) {
+        for (char* block : blocks[i]) {
+            pools[i]->deallocate(block);
+        }
+    }
+    BufferPool::setGlobalMaxBytes(0);
+}
@@ -22,8 +22,7 @@ using namespace std::chrono;
 
 // 服务器端消息回调：回显收到的消息
 void onMessage(const TcpConnectionPtr& conn, Buffer* buf, TimeStamp receiveTime) {
-    std::string msg = buf->retrieveAllAsString();
-    conn->send(msg);
+    conn->send(buf);
 }
 
 // 服务器端连接回调：记录连接状态
@@ -144,8 +143,7 @@ TEST(TcpServerTest, Throughput) {
     TcpServer server(&loop, listenAddr, "EchoServer");
     server.setConnectionCallback(onConnection);
     server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp) {
-        std::string msg = buf->retrieveAllAsString();
-        conn->send(msg);
+        conn->send(buf);
         conn->shutdown(); // Ensure connection closes after response
     });
     server.setThreadNum(8); // Increase threads
@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "CountDownLatch.h"
+#include "Logger.h"
+
+using namespace muduo;
+using namespace std::chrono;
+
+// 工作线程大量跨线程投递任务时，未被处理的唤醒只写一次 eventfd
+TEST(EventLoopTest, CoalescedWakeups) {
+    const int kProducers = 4;
+    const int kPerProducer = 100000;
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    const int64_t total = static_cast<int64_t>(kProducers) * kPerProducer;
+    int64_t counter = 0;
+    CountDownLatch finished(1);
+    uint64_t requestedBefore = loop->numWakeupsRequested();
+    uint64_t issuedBefore = loop->numWakeupsIssued();
+    auto start = steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kProducers; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < kPerProducer; ++j) {
+                loop->queueInLoop([&]() {
+                    if (++counter == total) {
+                        finished.countDown();
+                    }
+                });
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    finished.wait();
+    double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    uint64_t requested = loop->numWakeupsRequested() - requestedBefore;
+    uint64_t issued = loop->numWakeupsIssued() - issuedBefore;
+    LOG_INFO("EventLoop CoalescedWakeups: %ld tasks in %.3f seconds, %lu wakeups requested, %lu eventfd writes",
+             total, seconds, requested, issued);
+    EXPECT_EQ(counter, total);
+    EXPECT_EQ(requested, static_cast<uint64_t>(total));
+    EXPECT_LT(issued, requested / 10);
+}
+
+// 一问一答式投递：每次都要等上一个任务执行完才投递下一个，唤醒合并不能丢失任何一次唤醒
+TEST(EventLoopTest, NoLostWakeups) {
+    const int kRounds = 20000;
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    for (int i = 0; i < kRounds; ++i) {
+        CountDownLatch done(1);
+        loop->queueInLoop([&done]() { done.countDown(); });
+        done.wait();
+    }
+    // 丢失唤醒会让上面的等待卡住；IO 线程恰好还在同一批任务中时下一个任务会被同一次唤醒带走，合并是允许的
+    EXPECT_LE(loop->numWakeupsIssued(), loop->numWakeupsRequested());
+    EXPECT_EQ(loop->numWakeupsRequested(), static_cast<uint64_t>(kRounds));
+}
+
+// 突发的大量任务（如向 5 万个连接广播）执行期间，优先任务与定时器的延迟：不设预算时要等整批任务执行完，
+// 设置每轮预算后剩余任务推迟到下一轮，优先任务和定时器在一个预算周期内就能得到执行
+TEST(EventLoopTest, FunctorBudgetBoundsLatency) {
+    const int kStormTasks = 50000;
+    const auto kTaskCost = microseconds(2);
+
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool budget = (mode == 1);
+        EventLoopThread loopThread;
+        EventLoop* loop = loopThread.startLoop();
+        if (budget) {
+            CountDownLatch set(1);
+            loop->runInLoop([&]() {
+                loop->setFunctorBudget(256, 0.001);
+                set.countDown();
+            });
+            set.wait();
+        }
+
+        std::atomic<int> stormDone(0);
+        for (int i = 0; i < kStormTasks; ++i) {
+            loop->queueInLoop([&stormDone, kTaskCost]() {
+                auto end = steady_clock::now() + kTaskCost;
+                while (steady_clock::now() < end) {
+                }
+                ++stormDone;
+            });
+        }
+
+        // 风暴开始执行后再投递优先任务和定时器
+        while (stormDone == 0) {
+            std::this_thread::yield();
+        }
+        CountDownLatch fired(2);
+        auto timerDue = steady_clock::now() + milliseconds(2);
+        std::atomic<int64_t> timerLateUs(0);
+        loop->runAfter(0.002, [&]() {
+            timerLateUs = duration_cast<microseconds>(steady_clock::now() - timerDue).count();
+            fired.countDown();
+        });
+        auto urgentQueued = steady_clock::now();
+        std::atomic<int64_t> urgentLatencyUs(0);
+        loop->queueUrgentInLoop([&]() {
+            urgentLatencyUs = duration_cast<microseconds>(steady_clock::now() - urgentQueued).count();
+            fired.countDown();
+        });
+        fired.wait();
+        int completedWhenFired = stormDone;
+        while (stormDone < kStormTasks) {
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+
+        uint64_t exhausted = 0;
+        CountDownLatch read(1);
+        loop->runInLoop([&]() {
+            exhausted = loop->numFunctorBudgetExhausted();
+            read.countDown();
+        });
+        read.wait();
+        LOG_INFO("EventLoop FunctorBudget %s: urgent task latency %ld us, timer late by %ld us, "
+                 "%d of %d storm tasks done when both ran, budget exhausted %lu times",
+                 budget ? "on" : "off", urgentLatencyUs.load(), timerLateUs.load(),
+                 completedWhenFired, kStormTasks, exhausted);
+        if (budget) {
+            EXPECT_GT(exhausted, 0u);
+            EXPECT_GT(loop->numDeferredPolls(), 0u);
+            EXPECT_EQ(loop->numSpinPolls(), 0u);
+            EXPECT_LT(completedWhenFired, kStormTasks);
+            EXPECT_LT(urgentLatencyUs.load(), 20000);
+            EXPECT_LT(timerLateUs.load(), 20000);
+        }
+    }
+}
+
+// 忙轮询：有活动之后在窗口内 0 超时轮询，窗口过后回到阻塞等待；同时对比跨线程唤醒延迟
+// 注意单核机器上忙等的 IO 线程会与投递任务的线程争抢 CPU，延迟收益只有在多核上才明显
+TEST(EventLoopTest, BusyPollSpinsThenBlocks) {
+    const int kPings = 200;
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool busyPoll = (mode == 1);
+        EventLoopThread loopThread(busyPoll ? [](EventLoop* loop) { loop->setBusyPoll(0.005); }
+                                            : EventLoopThread::ThreadInitCallback());
+        EventLoop* loop = loopThread.startLoop();
+
+        // 每隔 200us 投递一个任务，统计从投递到执行的平均延迟
+        int64_t totalUs = 0;
+        for (int i = 0; i < kPings; ++i) {
+            CountDownLatch done(1);
+            auto queued = steady_clock::now();
+            std::atomic<int64_t> latencyUs(0);
+            loop->queueInLoop([&]() {
+                latencyUs = duration_cast<microseconds>(steady_clock::now() - queued).count();
+                done.countDown();
+            });
+            done.wait();
+            totalUs += latencyUs;
+            std::this_thread::sleep_for(microseconds(200));
+        }
+
+        double spinBefore = loop->spinSeconds();
+        uint64_t blockingBefore = loop->numBlockingPolls();
+        std::this_thread::sleep_for(milliseconds(50));  // 空闲超过窗口后应回到阻塞等待
+        double idleSpin = loop->spinSeconds() - spinBefore;
+        LOG_INFO("EventLoop BusyPoll %s: average wakeup latency %.1f us, %lu spin polls (%.3f s), "
+                 "%lu blocking polls (%.3f s), %lu deferred-work polls, spin during 50ms idle %.3f s",
+                 busyPoll ? "on" : "off", static_cast<double>(totalUs) / kPings,
+                 loop->numSpinPolls(), loop->spinSeconds(), loop->numBlockingPolls(), loop->blockSeconds(),
+                 loop->numDeferredPolls(), idleSpin);
+        if (busyPoll) {
+            EXPECT_GT(loop->numSpinPolls(), 0u);
+            EXPECT_LT(idleSpin, 0.04);
+            EXPECT_GT(loop->numBlockingPolls(), blockingBefore);
+        } else {
+            // 执行任务期间又有任务放入时下一轮同样以 0 超时轮询，但计入 numDeferredPolls，不算忙等
+            EXPECT_EQ(loop->numSpinPolls(), 0u);
+            EXPECT_EQ(loop->spinSeconds(), 0.0);
+            EXPECT_GE(loop->numBlockingPolls(), static_cast<uint64_t>(kPings / 2));
+        }
+    }
+}
+
+// 取消的定时器不再触发，回调持有的对象立即释放，不必等到原定的到期时间；在 IO 线程内外取消都可以
+TEST(EventLoopTest, CancelTimer) {
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    std::shared_ptr<int> token = std::make_shared<int>(0);
+    std::atomic<int> fired(0);
+    TimerId farAway = loop->runAfter(3600.0, [token]() {});
+    TimerId soon = loop->runAfter(0.05, [&fired]() { ++fired; });
+    TimerId repeating = loop->runEvery(0.01, [&fired]() { ++fired; });
+    EXPECT_EQ(token.use_count(), 2);
+    loop->cancel(farAway);
+    loop->cancel(soon);
+
+    // 在 IO 线程中添加后立即取消，以及重复定时器在自己的回调中取消自己
+    CountDownLatch selfCanceled(1);
+    std::shared_ptr<TimerId> self = std::make_shared<TimerId>();
+    loop->runInLoop([&, self]() {
+        TimerId id = loop->runAfter(0.01, [&fired]() { ++fired; });
+        loop->cancel(id);
+        *self = loop->runEvery(0.01, [&, self]() {
+            loop->cancel(*self);
+            selfCanceled.countDown();
+        });
+    });
+    loop->cancel(repeating);
+
+    CountDownLatch latch(1);
+    loop->runInLoop([&latch]() { latch.countDown(); });
+    latch.wait();
+    EXPECT_EQ(token.use_count(), 1);
+
+    selfCanceled.wait();
+    std::this_thread::sleep_for(milliseconds(100));
+    EXPECT_EQ(fired.load(), 0);
+    // 默认构造的 TimerId 无效，取消时忽略
+    loop->cancel(TimerId());
+}
+
+// 一轮任务中添加的一批定时器，每个都比前一个早到期：原来每个都要调用一次 timerfd_settime，现在合并为一次
+TEST(EventLoopTest, BatchedTimerRearm) {
+    const int kTimers = 10000;
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    CountDownLatch fired(kTimers);
+    std::atomic<int> early(0);
+    uint64_t requestedBefore = loop->numTimerRearmsRequested();
+    uint64_t issuedBefore = loop->numTimerRearmsIssued();
+    double addSeconds = 0;
+    loop->runInLoop([&]() {
+        auto start = steady_clock::now();
+        TimeStamp base = addTime(TimeStamp::now(), 0.1);
+        for (int i = 0; i < kTimers; ++i) {
+            TimeStamp when(base.microSecondsSinceEpoch() - i * 5);
+            loop->runAt(when, [&, when]() {
+                if (TimeStamp::now() < when) {
+                    ++early;
+                }
+                fired.countDown();
+            });
+        }
+        addSeconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    });
+    fired.wait();
+
+    uint64_t requested = loop->numTimerRearmsRequested() - requestedBefore;
+    uint64_t issued = loop->numTimerRearmsIssued() - issuedBefore;
+    LOG_INFO("EventLoop BatchedTimerRearm: %d timers added in %.3f ms, %lu rearms requested, %lu timerfd_settime calls",
+             kTimers, addSeconds * 1000, requested, issued);
+    EXPECT_EQ(early.load(), 0);
+    EXPECT_GE(requested, static_cast<uint64_t>(kTimers));
+    // 添加时一次，之后每次到期处理一次；这批定时器分布在约 50ms 内，按 1ms 精度到期
+    EXPECT_LT(issued, 100u);
+}
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdlib>
+#include <new>
+#include <unistd.h>
+
+#include "InlineFunction.h"
+#include "MpscQueue.h"
+#include "TcpConnection.h"
+#include "CountDownLatch.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+using namespace muduo;
+using namespace muduo::test;
+using namespace std::chrono;
+
+// 统计当前线程的堆分配次数：本文件单独编译成 inline_function_tests，替换的 operator new/delete 只作用于这个可执行文件，
+// 并且只在 AllocCounter 存活的区间内计数
+namespace {
+thread_local bool t_countAllocs = false;
+thread_local size_t t_numAllocs = 0;
+
+void* countedAlloc(size_t size) {
+    if (t_countAllocs) {
+        ++t_numAllocs;
+    }
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+class AllocCounter {
+public:
+    AllocCounter() : before_(t_numAllocs) { t_countAllocs = true; }
+    ~AllocCounter() { t_countAllocs = false; }
+    size_t count() const { return t_numAllocs - before_; }
+
+private:
+    size_t before_;
+};
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Session {
+    void onMessage(const std::string& message) { bytes += message.size(); }
+    size_t bytes = 0;
+};
+
+// 向队列投递 n 个典型的任务（成员函数 + shared_ptr + 移入的 std::string），返回平均每次投递的堆分配次数
+template <typename Functor>
+double allocsPerPush(int n) {
+    MpscQueue<Functor> queue;
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    std::vector<std::string> messages(n, std::string(256, 'm'));
+    for (int round = 0; round < 2; ++round) {   // 第一轮预热节点缓存
+        size_t allocs = 0;
+        {
+            AllocCounter counter;
+            for (int i = 0; i < n; ++i) {
+                queue.push(std::bind(&Session::onMessage, session, std::move(messages[i])));
+            }
+            allocs = counter.count();
+        }
+        queue.consumeAll([](Functor& f) { f(); });
+        if (round == 1) {
+            return static_cast<double>(allocs) / n;
+        }
+        messages.assign(n, std::string(256, 'm'));
+    }
+    return 0;
+}
+
+}
+
+TEST(InlineFunctionTest, InlineAndHeapStorage) {
+    std::shared_ptr<Session> session = std::make_shared<Session>();
+    Task small(std::bind(&Session::onMessage, session, std::string("hello")));
+    EXPECT_TRUE(small.isInline());
+    small();
+    EXPECT_EQ(session->bytes, 5u);
+
+    char big[128] = {0};
+    Task large([big, session]() { session->bytes += sizeof big; });
+    EXPECT_FALSE(large.isInline());
+    large();
+    EXPECT_EQ(session->bytes, 5u + sizeof big);
+
+    // 移动后源对象为空，被包装的对象只析构一次
+    Task moved(std::move(large));
+    EXPECT_FALSE(static_cast<bool>(large));
+    moved();
+    EXPECT_EQ(session->bytes, 5u + 2 * sizeof big);
+    moved = nullptr;
+    small = Task();
+    EXPECT_EQ(session.use_count(), 1);
+}
+
+TEST(InlineFunctionTest, MoveOnlyAndConversions) {
+    std::unique_ptr<int> owned(new int(41));
+    InlineFunction<int()> f([p = std::move(owned)]() { return ++*p; });
+    EXPECT_EQ(f(), 42);
+    EXPECT_EQ(f(), 43);
+
+    // 返回类型为 void 时丢弃返回值
+    Task discard([]() { return 1; });
+    discard();
+
+    // 空的 std::function 得到空的 InlineFunction
+    std::function<void()> empty;
+    Task fromEmpty(empty);
+    EXPECT_FALSE(static_cast<bool>(fromEmpty));
+
+    InlineFunction<void(TimeStamp), 32> withArg([](TimeStamp t) { EXPECT_TRUE(t.valid()); });
+    EXPECT_TRUE(withArg.isInline());
+    withArg(TimeStamp::now());
+}
+
+// 每次投递任务的堆分配次数：std::function 放不下绑定了 shared_ptr 和 std::string 的 std::bind，Task 可以内联存放
+TEST(InlineFunctionTest, AllocationsPerTask) {
+    const int kTasks = 2000;    // 不超过 MpscQueue 空闲链表保留的节点数
+    double stdFunction = allocsPerPush<std::function<void()>>(kTasks);
+    double task = allocsPerPush<Task>(kTasks);
+    LOG_INFO("InlineFunction AllocationsPerTask: std::function %.2f, Task %.2f heap allocations per queued task",
+             stdFunction, task);
+    EXPECT_GE(stdFunction, 1.0);
+    EXPECT_EQ(task, 0.0);
+}
+
+// 端到端：工作线程调用 TcpConnection::send(std::string&&) 跨线程发送，发送线程上不再有堆分配
+// 达到零拷贝阈值的消息同样直接移动进任务，不再包一层 shared_ptr
+TEST(InlineFunctionTest, CrossThreadSendAllocations) {
+    const int kMessages = 2000;
+    // IO 线程自己投递任务（如 corkedFlush）时，若本地缓存恰好用完会取走整个空闲链表，那一轮发送线程只能重新分配，
+    // 因此取第一轮预热之后各轮的最小值作为稳定状态下的结果
+    const int kRounds = 5;
+    const int kModes = 2;
+    const size_t kMessageSize = 1024;
+    TestServer server(8116, "AllocServer");
+    TcpConnectionPtr serverConn;
+    CountDownLatch connected(1);
+    server.start([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            serverConn = conn;
+            connected.countDown();
+        }
+    });
+
+    int fd = connectTo(8116);
+    ASSERT_GE(fd, 0);
+    connected.wait();
+    std::thread reader([fd]() {
+        char buf[65536];
+        size_t received = 0;
+        while (received < kModes * kRounds * kMessages * kMessageSize) {
+            ssize_t n = ::read(fd, buf, sizeof buf);
+            if (n <= 0) {
+                break;
+            }
+            received += n;
+        }
+    });
+
+    for (int mode = 0; mode < kModes; ++mode) {
+        const bool zeroCopy = (mode == 1);
+        bool zeroCopyEnabled = false;
+        server.runAndWait([&]() { zeroCopyEnabled = serverConn->setZeroCopyThreshold(zeroCopy ? kMessageSize : 0); });
+        double allocsPerSend = 1e9;
+        for (int round = 0; round < kRounds; ++round) {
+            std::vector<std::string> messages(kMessages, std::string(kMessageSize, 's'));
+            {
+                AllocCounter counter;
+                for (std::string& m : messages) {
+                    serverConn->send(std::move(m));
+                }
+                if (round > 0) {
+                    allocsPerSend = std::min(allocsPerSend, static_cast<double>(counter.count()) / kMessages);
+                }
+            }
+            server.runAndWait([]() {});
+        }
+        LOG_INFO("InlineFunction CrossThreadSendAllocations%s: %.3f heap allocations per cross-thread send",
+                 zeroCopy ? (zeroCopyEnabled ? " (zero-copy)" : " (zero-copy unsupported)") : "", allocsPerSend);
+        EXPECT_LT(allocsPerSend, 0.01);
+    }
+    reader.join();
+
+    server.runAndWait([&]() { serverConn.reset(); });
+    ::close(fd);
+}
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Buffer.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+using namespace muduo;
+using namespace muduo::test;
+using namespace std::chrono;
+
+namespace {
+
+// newDefaultPoller 在 io_uring 初始化失败时退回 epoll，此时 io_uring 的测试只是在拿 epoll 和自己比较
+bool ioUringAvailable() {
+    ::setenv("MUDUO_USE_IO_URING", "1", 1);
+    bool available = false;
+    std::thread t([&available]() {
+        EventLoop loop;
+        available = strcmp(loop.pollerName(), "io_uring") == 0;
+    });
+    t.join();
+    ::unsetenv("MUDUO_USE_IO_URING");
+    return available;
+}
+
+struct EchoResult {
+    std::string pollerName;
+    double requestsPerSecond;
+    double syscallsPerRequest;
+    double bulkSyscallsPerMB;
+    bool echoedCorrectly;
+};
+
+// 单线程回显服务器：先是 kClients 个长连接的乒乓请求，再是大块数据回显（触发写事件的开关），最后是一批短连接
+EchoResult runEchoBenchmark(bool useIoUring, int port) {
+    const int kClients = 8;
+    const int kRequestsPerClient = 5000;
+    const size_t kRequestSize = 64;
+    const size_t kBulkSize = 16 * 1024 * 1024;
+    const int kShortConnections = 500;
+
+    if (useIoUring) {
+        ::setenv("MUDUO_USE_IO_URING", "1", 1);
+    } else {
+        ::unsetenv("MUDUO_USE_IO_URING");
+    }
+    TestServer server(port, "EchoServer");
+    ::unsetenv("MUDUO_USE_IO_URING");
+    EventLoop* loop = server.loop();
+    server.start([](const TcpConnectionPtr&) {},
+                 [](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp) {
+                     conn->send(buf);
+                 });
+
+    EchoResult result;
+    result.pollerName = loop->pollerName();
+    std::atomic<bool> ok(true);
+
+    uint64_t syscallsBefore = loop->numPollerSyscalls();
+    auto start = steady_clock::now();
+    std::vector<std::thread> clients;
+    for (int i = 0; i < kClients; ++i) {
+        clients.emplace_back([&, i]() {
+            int fd = connectTo(port, true);
+            if (fd < 0) {
+                ok = false;
+                return;
+            }
+            std::string request(kRequestSize, static_cast<char>('a' + i));
+            char response[kRequestSize];
+            for (int j = 0; j < kRequestsPerClient; ++j) {
+                if (::write(fd, request.data(), request.size()) != static_cast<ssize_t>(request.size()) ||
+                    !readFully(fd, response, sizeof response) ||
+                    memcmp(response, request.data(), sizeof response) != 0) {
+                    ok = false;
+                    break;
+                }
+            }
+            ::close(fd);
+        });
+    }
+    for (std::thread& t : clients) {
+        t.join();
+    }
+    double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    const int totalRequests = kClients * kRequestsPerClient;
+    result.requestsPerSecond = totalRequests / seconds;
+    result.syscallsPerRequest = static_cast<double>(loop->numPollerSyscalls() - syscallsBefore) / totalRequests;
+
+    // 大块数据：客户端写满内核缓冲区，服务器的输出缓冲区积压后反复开关写事件
+    syscallsBefore = loop->numPollerSyscalls();
+    int fd = connectTo(port, true);
+    if (fd < 0) {
+        ok = false;
+    } else {
+        std::string bulk(kBulkSize, 0);
+        for (size_t i = 0; i < bulk.size(); ++i) {
+            bulk[i] = static_cast<char>(i * 131);
+        }
+        std::thread writer([fd, &bulk]() { writeAll(fd, bulk); });
+        std::string echoed(kBulkSize, 0);
+        if (!readFully(fd, &echoed[0], echoed.size()) || echoed != bulk) {
+            ok = false;
+        }
+        writer.join();
+        ::close(fd);
+    }
+    result.bulkSyscallsPerMB = static_cast<double>(loop->numPollerSyscalls() - syscallsBefore) / (kBulkSize >> 20);
+
+    // 短连接：Channel 频繁加入和移除，连接关闭后端口与 fd 能正常复用
+    for (int i = 0; i < kShortConnections; ++i) {
+        fd = connectTo(port, true);
+        char c = 'x';
+        if (fd < 0 || ::write(fd, &c, 1) != 1 || !readFully(fd, &c, 1) || c != 'x') {
+            ok = false;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    result.echoedCorrectly = ok;
+    return result;
+}
+
+}
+
+// 与 EpollPoller 对比回显的正确性；吞吐量和 Poller 所用的系统调用次数只记录在日志中，不作为断言
+// IoUringPoller 只替换就绪通知，收发数据的系统调用与 epoll 相同
+TEST(IoUringPollerTest, EchoBenchmark) {
+    if (!ioUringAvailable()) {
+        GTEST_SKIP() << "io_uring is unavailable";
+    }
+    EchoResult epoll = runEchoBenchmark(false, 8117);
+    EchoResult uring = runEchoBenchmark(true, 8118);
+    LOG_INFO("IoUringPoller EchoBenchmark epoll: %.0f requests/s, %.2f poller syscalls per request, %.1f per MB bulk",
+             epoll.requestsPerSecond, epoll.syscallsPerRequest, epoll.bulkSyscallsPerMB);
+    LOG_INFO("IoUringPoller EchoBenchmark io_uring: %.0f requests/s, %.2f poller syscalls per request, %.1f per MB bulk",
+             uring.requestsPerSecond, uring.syscallsPerRequest, uring.bulkSyscallsPerMB);
+    EXPECT_EQ(epoll.pollerName, "epoll");
+    EXPECT_EQ(uring.pollerName, "io_uring");
+    EXPECT_TRUE(epoll.echoedCorrectly);
+    EXPECT_TRUE(uring.echoedCorrectly);
+}
+
+// 服务器在 IO 线程退出之后、在其他线程中析构，监听端口要能立即重新绑定
+TEST(IoUringPollerTest, PortReusableAfterLoopExits) {
+    if (!ioUringAvailable()) {
+        GTEST_SKIP() << "io_uring is unavailable";
+    }
+    std::unique_ptr<EventLoop> loop;
+    std::unique_ptr<TcpServer> server;
+    ::setenv("MUDUO_USE_IO_URING", "1", 1);
+    std::thread loopThread([&]() {
+        loop.reset(new EventLoop);
+        server.reset(new TcpServer(loop.get(), InetAddress(8119), "ReuseServer"));
+        server->setConnectionCallback([](const TcpConnectionPtr&) {});
+        server->start();
+        EventLoop* l = loop.get();
+        l->runAfter(0.02, [l]() { l->quit(); });
+        l->loop();
+    });
+    loopThread.join();
+    ::unsetenv("MUDUO_USE_IO_URING");
+
+    EXPECT_STREQ(loop->pollerName(), "io_uring");
+    server.reset();
+    EXPECT_TRUE(canBind(8119));
+    loop.reset();
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <endian.h>
+#include <unistd.h>
+
+#include "TcpConnection.h"
+#include "LengthHeaderCodec.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+using namespace muduo;
+using namespace muduo::test;
+using namespace std::chrono;
+
+namespace {
+
+std::string frame(const std::string& body) {
+    Buffer buf;
+    LengthHeaderCodec::encode(&buf, body);
+    return buf.retrieveAllAsString();
+}
+
+// 读取一个完整的消息，连接关闭时返回 false
+bool readFrame(int fd, Buffer* buf, std::string* body) {
+    while (buf->readableBytes() < LengthHeaderCodec::kHeaderLen ||
+           buf->readableBytes() < LengthHeaderCodec::kHeaderLen + static_cast<size_t>(buf->peekInt32())) {
+        int savedErrno = 0;
+        if (buf->readFd(fd, &savedErrno) <= 0) {
+            return false;
+        }
+    }
+    size_t len = buf->readInt32();
+    *body = buf->retrieveAsString(len);
+    return true;
+}
+
+// 回显服务器：收到的每个消息原样编码回去，单个 IO 线程
+// bufferReplies 为 true 时连接建立后先用 send(conn, Buffer*) 发一个问候消息，批量回调中也交替使用 Buffer 发送
+class CodecEchoServer {
+public:
+    CodecEchoServer(int port, size_t maxFrameSize = LengthHeaderCodec::kDefaultMaxFrameSize, bool bufferReplies = false)
+        : codec_(std::bind(&CodecEchoServer::onFrames, this,
+                           std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
+                 maxFrameSize),
+          maxBatch_(0),
+          bufferReplies_(bufferReplies),
+          server_(port, "CodecEchoServer") {
+        server_.start(std::bind(&CodecEchoServer::onConnection, this, std::placeholders::_1),
+                      std::bind(&LengthHeaderCodec::onMessage, &codec_,
+                                std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    }
+
+    size_t maxBatch() const { return maxBatch_; }
+
+private:
+    void onConnection(const TcpConnectionPtr& conn) {
+        if (bufferReplies_ && conn->connected()) {
+            Buffer greeting;
+            greeting.append("welcome");
+            codec_.send(conn, &greeting);
+        }
+    }
+
+    void onFrames(const TcpConnectionPtr& conn, const std::vector<StringPiece>& frames, TimeStamp) {
+        if (frames.size() > maxBatch_) {
+            maxBatch_ = frames.size();
+        }
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (bufferReplies_ && i % 2 == 1) {
+                Buffer body;
+                body.append(frames[i].data(), frames[i].size());
+                codec_.send(conn, &body);
+            } else {
+                codec_.send(conn, frames[i]);
+            }
+        }
+    }
+
+    LengthHeaderCodec codec_;
+    std::atomic<size_t> maxBatch_;
+    const bool bufferReplies_;
+    TestServer server_;     // 最后构造、最先析构，TcpServer 销毁之前 codec_ 一直有效
+};
+
+}
+
+// 多个消息一次到达时合并成一次回调；消息被拆成多段到达时等待完整后再回调
+TEST(LengthHeaderCodecTest, BatchAndPartialFrames) {
+    CodecEchoServer server(8091);
+    int fd = connectTo(8091);
+    ASSERT_GE(fd, 0);
+
+    std::string first = frame("hello") + frame("") + frame(std::string(1000, 'x'));
+    std::string last = frame("world");
+    ASSERT_TRUE(writeAll(fd, first + last.substr(0, 6)));
+    std::this_thread::sleep_for(milliseconds(50));
+    ASSERT_TRUE(writeAll(fd, last.substr(6)));
+
+    Buffer buf;
+    std::string body;
+    ASSERT_TRUE(readFrame(fd, &buf, &body));
+    EXPECT_EQ(body, "hello");
+    ASSERT_TRUE(readFrame(fd, &buf, &body));
+    EXPECT_EQ(body, "");
+    ASSERT_TRUE(readFrame(fd, &buf, &body));
+    EXPECT_EQ(body, std::string(1000, 'x'));
+    ASSERT_TRUE(readFrame(fd, &buf, &body));
+    EXPECT_EQ(body, "world");
+    EXPECT_GE(server.maxBatch(), 3u);
+
+    ::close(fd);
+}
+
+// send(conn, Buffer*) 把长度头写进 body 的预留空间：批量回调内外都与 StringPiece 的消息按顺序到达
+TEST(LengthHeaderCodecTest, BufferBodyFraming) {
+    CodecEchoServer server(8125, LengthHeaderCodec::kDefaultMaxFrameSize, true);
+    int fd = connectTo(8125);
+    ASSERT_GE(fd, 0);
+
+    Buffer buf;
+    std::string body;
+    ASSERT_TRUE(readFrame(fd, &buf, &body));
+    EXPECT_EQ(body, "welcome");
+
+    std::vector<std::string> bodies;
+    std::string batch;
+    for (int i = 0; i < 6; ++i) {
+        bodies.push_back(std::string(100 * i, static_cast<char>('a' + i)));
+        batch += frame(bodies.back());
+    }
+    ASSERT_TRUE(writeAll(fd, batch));
+    for (const std::string& expected : bodies) {
+        ASSERT_TRUE(readFrame(fd, &buf, &body));
+        EXPECT_EQ(body, expected);
+    }
+
+    ::close(fd);
+}
+
+// 长度超过上限的消息直接断开连接
+TEST(LengthHeaderCodecTest, OversizedFrameClosesConnection) {
+    CodecEchoServer server(8092, 1024);
+    int fd = connectTo(8092);
+    ASSERT_GE(fd, 0);
+
+    uint32_t be32 = htobe32(4096);
+    ASSERT_EQ(::write(fd, &be32, sizeof be32), static_cast<ssize_t>(sizeof be32));
+
+    char c;
+    EXPECT_EQ(::read(fd, &c, 1), 0);
+    ::close(fd);
+}
+
+// 单个 IO 线程每秒能解码并回复的消息数，客户端每次流水线发送一批消息
+TEST(LengthHeaderCodecTest, Benchmark) {
+    CodecEchoServer server(8093);
+    int fd = connectTo(8093);
+    ASSERT_GE(fd, 0);
+
+    const int kFramesPerBatch = 256;
+    const int kBatches = 2000;
+    std::string batch;
+    for (int i = 0; i < kFramesPerBatch; ++i) {
+        batch += frame(std::string(64, 'a' + i % 26));
+    }
+
+    Buffer buf;
+    std::string body;
+    auto start = steady_clock::now();
+    for (int i = 0; i < kBatches; ++i) {
+        ASSERT_TRUE(writeAll(fd, batch));
+        for (int j = 0; j < kFramesPerBatch; ++j) {
+            ASSERT_TRUE(readFrame(fd, &buf, &body));
+        }
+    }
+    double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    int64_t frames = static_cast<int64_t>(kFramesPerBatch) * kBatches;
+    LOG_INFO("LengthHeaderCodec Benchmark: %ld frames of 64 bytes, %.2f seconds, %.0f frames/s on one IO thread, max batch %zu",
+             frames, seconds, frames / seconds, server.maxBatch());
+
+    ::close(fd);
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+#include "MpscQueue.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "CountDownLatch.h"
+#include "Logger.h"
+
+using namespace muduo;
+using namespace std::chrono;
+
+namespace {
+
+// 原来 EventLoop 中的实现：加锁 push_back，消费者加锁后整体 swap
+class MutexVectorQueue {
+public:
+    void push(std::function<void()> cb) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(cb));
+    }
+
+    template <typename F>
+    size_t consumeAll(F&& f) {
+        std::vector<std::function<void()>> functors;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            functors.swap(pending_);
+        }
+        for (std::function<void()>& functor : functors) {
+            f(functor);
+        }
+        return functors.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::function<void()>> pending_;
+};
+
+// kProducers 个线程各放入 kPerProducer 个任务，一个消费者线程不断取出执行，返回每秒处理的任务数
+template <typename Queue>
+double runQueueBenchmark(int producers, int perProducer) {
+    Queue queue;
+    std::atomic<bool> done(false);
+    int64_t counter = 0;
+    const int64_t total = static_cast<int64_t>(producers) * perProducer;
+
+    auto start = steady_clock::now();
+    std::thread consumer([&]() {
+        while (counter < total) {
+            queue.consumeAll([](std::function<void()>& f) { f(); });
+        }
+        done = true;
+    });
+    std::vector<std::thread> threads;
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < perProducer; ++j) {
+                queue.push([&counter]() { ++counter; });
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    consumer.join();
+    double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    EXPECT_TRUE(done);
+    EXPECT_EQ(counter, total);
+    return total / seconds;
+}
+
+}
+
+// 多个生产者并发放入，每个生产者放入的元素按先后顺序被取出，不丢失也不重复
+TEST(MpscQueueTest, PerProducerFifo) {
+    const int kProducers = 4;
+    const int kPerProducer = 100000;
+    MpscQueue<std::pair<int, int>> queue;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kProducers; ++i) {
+        threads.emplace_back([&queue, i]() {
+            for (int j = 0; j < kPerProducer; ++j) {
+                queue.push(std::make_pair(i, j));
+            }
+        });
+    }
+
+    std::vector<int> next(kProducers, 0);
+    size_t consumed = 0;
+    bool ordered = true;
+    while (consumed < static_cast<size_t>(kProducers * kPerProducer)) {
+        consumed += queue.consumeAll([&](std::pair<int, int>& item) {
+            if (item.second != next[item.first]) {
+                ordered = false;
+            }
+            next[item.first] = item.second + 1;
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.empty());
+    for (int i = 0; i < kProducers; ++i) {
+        EXPECT_EQ(next[i], kPerProducer);
+    }
+}
+
+// 一次突发投递之后，空闲链表和本地缓存只保留有限的节点，其余的释放掉
+TEST(MpscQueueTest, FreeListIsBounded) {
+    typedef MpscQueue<std::pair<long, long>> Queue;
+    const int kBurst = 100000;
+    {
+        Queue queue;
+        for (int i = 0; i < kBurst; ++i) {
+            queue.push(std::make_pair(i, i));
+        }
+        EXPECT_EQ(queue.consumeAll([](std::pair<long, long>&) {}), static_cast<size_t>(kBurst));
+        EXPECT_LE(Queue::cachedNodes(), 2 * Queue::kMaxFreeNodes);
+
+        // 回收的节点仍然可以复用
+        long sum = 0;
+        for (int i = 0; i < kBurst; ++i) {
+            queue.push(std::make_pair(i, 1));
+        }
+        queue.consumeAll([&sum](std::pair<long, long>& item) { sum += item.second; });
+        EXPECT_EQ(sum, kBurst);
+    }
+    EXPECT_LE(Queue::cachedNodes(), 2 * Queue::kMaxFreeNodes);
+}
+
+// 队列本身的吞吐量：N 个生产者线程对一个消费者，无锁队列与加锁 vector 交换对比
+TEST(MpscQueueTest, Benchmark) {
+    const int kPerProducer = 200000;
+    for (int producers : {1, 4, 8}) {
+        double mutexRate = runQueueBenchmark<MutexVectorQueue>(producers, kPerProducer);
+        double mpscRate = runQueueBenchmark<MpscQueue<std::function<void()>>>(producers, kPerProducer);
+        LOG_INFO("MpscQueue Benchmark: %d producers, mutex+vector %.0f tasks/s, mpsc %.0f tasks/s",
+                 producers, mutexRate, mpscRate);
+    }
+}
+
+// 端到端：N 个线程通过 queueInLoop 向同一个 EventLoop 投递任务
+TEST(MpscQueueTest, QueueInLoopBenchmark) {
+    const int kProducers = 4;
+    const int kPerProducer = 200000;
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    int64_t counter = 0;
+    CountDownLatch finished(1);
+    const int64_t total = static_cast<int64_t>(kProducers) * kPerProducer;
+    auto start = steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kProducers; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < kPerProducer; ++j) {
+                loop->queueInLoop([&]() {
+                    if (++counter == total) {
+                        finished.countDown();
+                    }
+                });
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    finished.wait();
+    double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    LOG_INFO("QueueInLoop Benchmark: %d producers, %.0f tasks/s", kProducers, total / seconds);
+    EXPECT_EQ(counter, total);
+}
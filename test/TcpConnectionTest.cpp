@@ -0,0 +1,815 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <functional>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <map>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdlib.h>
+
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "CountDownLatch.h"
+#include "InetAddress.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+using namespace muduo;
+using namespace muduo::test;
+using namespace std::chrono;
+
+namespace {
+
+// 依次接受的两个连接配成一对互相转发：splice 为 true 时使用 spliceTo，否则读进 inputBuffer_ 后 send 给对方
+// highWaterMark 不为 0 时开启流控：一端的发送缓冲区超过高水位时暂停读取另一端，降到高水位的四分之一时恢复
+// splice 模式下暂停和恢复由 TcpConnection 自己完成，这里的水位回调只计数
+class ProxyPairs {
+public:
+    ProxyPairs(TestServer* server, bool splice, size_t highWaterMark = 0)
+        : server_(server), highWaterMark_(highWaterMark), paired_(1), disconnected_(0), highs_(0), lows_(0) {
+        server_->start([this, splice](const TcpConnectionPtr& conn) { onConnection(conn, splice); },
+                       [this](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp) {
+                           auto it = peers_.find(conn->name());
+                           if (it != peers_.end()) {
+                               it->second->send(buf);
+                           }
+                       });
+    }
+
+    ~ProxyPairs() {
+        server_->runAndWait([this]() {
+            peers_.clear();
+            waiting_.reset();
+        });
+    }
+
+    void waitPaired() { paired_.wait(); }
+    int disconnected() const { return disconnected_; }
+    int highs() const { return highs_; }
+    int lows() const { return lows_; }
+
+private:
+    void onConnection(const TcpConnectionPtr& conn, bool splice) {
+        if (!conn->connected()) {
+            auto it = peers_.find(conn->name());
+            if (it != peers_.end()) {
+                if (!splice) {
+                    it->second->shutdown();
+                }
+                peers_.erase(it);
+            }
+            ++disconnected_;
+            return;
+        }
+        if (!waiting_) {
+            waiting_ = conn;
+            return;
+        }
+        peers_[conn->name()] = waiting_;
+        peers_[waiting_->name()] = conn;
+        if (splice) {
+            if (highWaterMark_ > 0) {
+                countWaterMarks(conn);
+                countWaterMarks(waiting_);
+            }
+            waiting_->spliceTo(conn);
+            conn->spliceTo(waiting_);
+        } else if (highWaterMark_ > 0) {
+            throttle(conn, waiting_);
+            throttle(waiting_, conn);
+        }
+        waiting_.reset();
+        paired_.countDown();
+    }
+
+    // 回调中持有 weak_ptr，避免两个连接互相引用
+    void throttle(const TcpConnectionPtr& downstream, const TcpConnectionPtr& upstream) {
+        std::weak_ptr<TcpConnection> weakUpstream(upstream);
+        downstream->setHighWaterMarkCallback([weakUpstream](const TcpConnectionPtr&, size_t) {
+            TcpConnectionPtr up = weakUpstream.lock();
+            if (up) {
+                up->stopRead();
+            }
+        }, highWaterMark_);
+        downstream->setLowWaterMarkCallback([weakUpstream](const TcpConnectionPtr&, size_t) {
+            TcpConnectionPtr up = weakUpstream.lock();
+            if (up) {
+                up->startRead();
+            }
+        }, highWaterMark_ / 4);
+    }
+
+    void countWaterMarks(const TcpConnectionPtr& conn) {
+        conn->setHighWaterMarkCallback([this](const TcpConnectionPtr&, size_t) { ++highs_; }, highWaterMark_);
+        conn->setLowWaterMarkCallback([this](const TcpConnectionPtr&, size_t) { ++lows_; }, highWaterMark_ / 4);
+    }
+
+    TestServer* server_;
+    const size_t highWaterMark_;
+    TcpConnectionPtr waiting_;
+    std::map<std::string, TcpConnectionPtr> peers_;
+    CountDownLatch paired_;
+    std::atomic<int> disconnected_;
+    std::atomic<int> highs_;
+    std::atomic<int> lows_;
+};
+
+}
+
+// 多个分片一次 writev 发出，内核写不下的部分逐个分片追加到发送缓冲区，数据顺序不变
+TEST(TcpConnectionTest, SendIovec) {
+    const std::string header = "HEADER:";
+    std::string body(8 * 1024 * 1024, 'b');
+    for (size_t i = 0; i < body.size(); i += 4096) {
+        body[i] = static_cast<char>('a' + (i / 4096) % 26);
+    }
+    const std::string trailer = ":TRAILER";
+
+    TestServer server(8101);
+    server.start([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            struct iovec iov[3];
+            iov[0].iov_base = const_cast<char*>(header.data());
+            iov[0].iov_len = header.size();
+            iov[1].iov_base = const_cast<char*>(body.data());
+            iov[1].iov_len = body.size();
+            iov[2].iov_base = const_cast<char*>(trailer.data());
+            iov[2].iov_len = trailer.size();
+            conn->send(iov, 3);
+            conn->shutdown();
+        }
+    });
+
+    int fd = connectTo(8101);
+    ASSERT_GE(fd, 0);
+    std::string received = readUntilClose(fd);
+    EXPECT_EQ(received.size(), header.size() + body.size() + trailer.size());
+    EXPECT_TRUE(received == header + body + trailer);
+    ::close(fd);
+}
+
+// 工作线程向 IO 线程发送数据的吞吐量：send(const StringPiece&) 跨线程时拷贝一份，send(std::string&&) 直接移动进任务
+TEST(TcpConnectionTest, CrossThreadSendBenchmark) {
+    const int kThreads = 4;
+    const int kMessagesPerThread = 20000;
+    const size_t kMessageSize = 4096;
+    const size_t kTotalBytes = kThreads * kMessagesPerThread * kMessageSize;
+
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool moveIn = (mode == 1);
+        TestServer server(8102 + mode);
+        TcpConnectionPtr serverConn;
+        CountDownLatch connected(1);
+        server.start([&](const TcpConnectionPtr& conn) {
+            if (conn->connected()) {
+                serverConn = conn;
+                connected.countDown();
+            }
+        });
+
+        int fd = connectTo(8102 + mode);
+        ASSERT_GE(fd, 0);
+        connected.wait();
+
+        auto start = steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < kThreads; ++t) {
+            workers.emplace_back([&serverConn, moveIn, t]() {
+                for (int i = 0; i < kMessagesPerThread; ++i) {
+                    std::string message(kMessageSize, static_cast<char>('a' + t));
+                    if (moveIn) {
+                        serverConn->send(std::move(message));
+                    } else {
+                        serverConn->send(message);
+                    }
+                }
+            });
+        }
+
+        size_t received = 0;
+        char buf[65536];
+        while (received < kTotalBytes) {
+            ssize_t n = ::read(fd, buf, sizeof buf);
+            if (n <= 0) {
+                break;
+            }
+            received += n;
+        }
+        double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+        for (auto& w : workers) {
+            w.join();
+        }
+        LOG_INFO("Cross-thread send [%s]: %zu bytes, %.2f seconds, %.2f MB/s, %.0f messages/s",
+                 moveIn ? "std::string&&" : "const StringPiece&", received, seconds,
+                 received / seconds / 1024 / 1024, kThreads * kMessagesPerThread / seconds);
+        EXPECT_EQ(received, kTotalBytes);
+
+        serverConn.reset();
+        ::close(fd);
+    }
+}
+
+// 每个请求的响应分 5 次 send：关闭 autoCork 时每次 send 一次 write，开启后每个请求只需一次 writev
+// 未开启 TCP_NODELAY 时多次小包写还会触发 Nagle 与延迟确认的等待，耗时差距会更明显
+TEST(TcpConnectionTest, AutoCorkCoalescesSmallSends) {
+    const int kRequests = 50;
+    const int kParts = 5;
+    const std::string kPart = "part-data;";
+
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool cork = (mode == 1);
+        TestServer server(8104 + mode);
+        TcpConnectionPtr serverConn;
+        server.start([&](const TcpConnectionPtr& conn) {
+            if (conn->connected()) {
+                conn->setAutoCork(cork);
+                serverConn = conn;
+            }
+        }, [&](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp) {
+            buf->retrieveAll();
+            for (int i = 0; i < kParts; ++i) {
+                conn->send(kPart);
+            }
+        });
+
+        int fd = connectTo(8104 + mode);
+        ASSERT_GE(fd, 0);
+        const size_t kResponseSize = kParts * kPart.size();
+        char buf[1024];
+        auto start = steady_clock::now();
+        for (int i = 0; i < kRequests; ++i) {
+            ASSERT_EQ(::write(fd, "?", 1), 1);
+            size_t received = 0;
+            while (received < kResponseSize) {
+                ssize_t n = ::read(fd, buf, sizeof buf);
+                ASSERT_GT(n, 0);
+                received += n;
+            }
+            ASSERT_EQ(received, kResponseSize);
+        }
+        double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+        uint64_t sends = 0;
+        uint64_t syscalls = 0;
+        server.runAndWait([&]() {
+            sends = serverConn->numSendCalls();
+            syscalls = serverConn->numWriteSyscalls();
+            serverConn.reset();
+        });
+        LOG_INFO("AutoCork %s: %d requests, %lu send calls, %lu write syscalls, %.3f seconds",
+                 cork ? "on" : "off", kRequests, sends, syscalls, seconds);
+        EXPECT_EQ(sends, static_cast<uint64_t>(kRequests * kParts));
+        if (cork) {
+            EXPECT_EQ(syscalls, static_cast<uint64_t>(kRequests));
+        } else {
+            EXPECT_EQ(syscalls, static_cast<uint64_t>(kRequests * kParts));
+        }
+        ::close(fd);
+    }
+}
+
+// 大块数据走 MSG_ZEROCOPY，小块数据走普通路径，接收端看到的顺序与发送顺序一致，所有零拷贝发送最终都收到完成通知
+TEST(TcpConnectionTest, ZeroCopySendKeepsOrder) {
+    const size_t kThreshold = 64 * 1024;
+    TestServer server(8106);
+    TcpConnectionPtr serverConn;
+    std::string expected;
+    server.start([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            serverConn = conn;
+            ASSERT_TRUE(conn->setZeroCopyThreshold(kThreshold));
+            for (int i = 0; i < 8; ++i) {
+                std::string small = "small-" + std::to_string(i);
+                std::string big(256 * 1024 + i, static_cast<char>('a' + i));
+                expected += small + big;
+                conn->send(small);
+                conn->send(std::move(big));
+            }
+            conn->send("end");
+            expected += "end";
+            conn->shutdown();
+        }
+    });
+
+    int fd = connectTo(8106);
+    ASSERT_GE(fd, 0);
+    std::string received = readUntilClose(fd);
+    EXPECT_EQ(received.size(), expected.size());
+    EXPECT_TRUE(received == expected);
+
+    // 半关闭要等到全部完成通知都收到之后，读到 EOF 时数据已经不再被内核引用
+    uint64_t sends = 0;
+    uint64_t completions = 0;
+    server.runAndWait([&]() {
+        sends = serverConn->numZeroCopySends();
+        completions = serverConn->numZeroCopyCompletions();
+    });
+    EXPECT_GE(sends, 8u);
+    EXPECT_EQ(completions, sends);
+    server.runAndWait([&]() { serverConn.reset(); });
+    ::close(fd);
+}
+
+// 回环上的吞吐量与每 GB 消耗的 CPU 时间（进程总 CPU，包括接收端）：普通拷贝路径与 MSG_ZEROCOPY 对比
+// 回环连接上内核会退化为拷贝，这里主要验证零拷贝路径省去了 outputBuffer_ 的那次拷贝，真实网卡上收益更大
+TEST(TcpConnectionTest, ZeroCopyBenchmark) {
+    const int kMessages = 128;
+    const size_t kMessageSize = 1024 * 1024;
+    const size_t kTotalBytes = kMessages * kMessageSize;
+
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool zeroCopy = (mode == 1);
+        TestServer server(8107 + mode);
+        TcpConnectionPtr serverConn;
+        CountDownLatch connected(1);
+        server.start([&](const TcpConnectionPtr& conn) {
+            if (conn->connected()) {
+                conn->setZeroCopyThreshold(zeroCopy ? 64 * 1024 : 0);
+                serverConn = conn;
+                connected.countDown();
+            }
+        });
+
+        int fd = connectTo(8107 + mode);
+        ASSERT_GE(fd, 0);
+        connected.wait();
+
+        std::vector<std::string> messages;
+        for (int i = 0; i < kMessages; ++i) {
+            messages.push_back(std::string(kMessageSize, static_cast<char>('a' + i % 26)));
+        }
+
+        struct timespec cpuStart, cpuEnd;
+        ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuStart);
+        auto start = steady_clock::now();
+        for (auto& m : messages) {
+            serverConn->send(std::move(m));
+        }
+        size_t received = 0;
+        char buf[65536];
+        while (received < kTotalBytes) {
+            ssize_t n = ::read(fd, buf, sizeof buf);
+            if (n <= 0) {
+                break;
+            }
+            received += n;
+        }
+        double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+        ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuEnd);
+        double cpuSeconds = (cpuEnd.tv_sec - cpuStart.tv_sec) + (cpuEnd.tv_nsec - cpuStart.tv_nsec) / 1e9;
+        EXPECT_EQ(received, kTotalBytes);
+
+        uint64_t zcSends = 0;
+        uint64_t zcCopied = 0;
+        server.runAndWait([&]() {
+            zcSends = serverConn->numZeroCopySends();
+            zcCopied = serverConn->numZeroCopyCopied();
+            serverConn.reset();
+        });
+        LOG_INFO("ZeroCopy %s: %.2f MB/s, %.3f CPU seconds per GB, %lu zerocopy sends (%lu copied by kernel)",
+                 zeroCopy ? "on" : "off", received / seconds / 1024 / 1024,
+                 cpuSeconds / (received / 1e9), zcSends, zcCopied);
+        ::close(fd);
+    }
+}
+
+// 文件与缓冲区数据按调用顺序发送；接收端暂停读取时等待 EPOLLOUT 而不是反复重试，全部写完后写完成回调只触发一次
+TEST(TcpConnectionTest, SendFileInOrderWithBackpressure) {
+    char path[] = "/tmp/mymuduo_sendfile_XXXXXX";
+    int fileFd = ::mkstemp(path);
+    ASSERT_GE(fileFd, 0);
+    ::unlink(path);
+    std::string content(32 * 1024 * 1024, 'f');
+    for (size_t i = 0; i < content.size(); i += 1000) {
+        content[i] = static_cast<char>('a' + (i / 1000) % 26);
+    }
+    ASSERT_EQ(::write(fileFd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+
+    const int kClients = 4;
+    const size_t kHalf = content.size() / 2;
+    const std::string expected = "BEGIN" + content.substr(kHalf) + "MIDDLE" + content.substr(0, kHalf) + "END";
+
+    TestServer server(8109);
+    std::vector<TcpConnectionPtr> conns;
+    std::atomic<int> writeCompletes(0);
+    server.start([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            conns.push_back(conn);
+            // "BEGIN" 直接写完时就会触发一次写完成回调，之后再设置，只统计文件及其后数据全部写完时的那一次
+            conn->send("BEGIN");
+            conn->setWriteCompleteCallback([&](const TcpConnectionPtr&) { ++writeCompletes; });
+            conn->sendFile(fileFd, kHalf, content.size() - kHalf);
+            conn->send("MIDDLE");
+            conn->sendFile(fileFd, 0, kHalf);
+            conn->send("END");
+            conn->shutdown();
+        }
+    });
+
+    std::vector<int> fds;
+    for (int i = 0; i < kClients; ++i) {
+        int fd = connectTo(8109);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    // 先不读，让服务端的发送缓冲区写满
+    std::this_thread::sleep_for(milliseconds(200));
+    for (int fd : fds) {
+        std::string received = readUntilClose(fd);
+        EXPECT_EQ(received.size(), expected.size());
+        EXPECT_TRUE(received == expected);
+        ::close(fd);
+    }
+
+    uint64_t maxSyscalls = 0;
+    server.runAndWait([&]() {
+        for (const TcpConnectionPtr& conn : conns) {
+            maxSyscalls = std::max(maxSyscalls, conn->numWriteSyscalls());
+        }
+        conns.clear();
+    });
+    LOG_INFO("SendFile: %d concurrent transfers of %zu bytes, at most %lu write syscalls per connection",
+             kClients, content.size(), maxSyscalls);
+    EXPECT_EQ(writeCompletes.load(), kClients);
+    EXPECT_LT(maxSyscalls, 2000u);
+    ::close(fileFd);
+}
+
+// sendfile 途中文件被截短：剩余的数据再也发不出去，丢弃并断开连接，而不是在水平触发的 EPOLLOUT 上空转
+TEST(TcpConnectionTest, SendFileTruncatedClosesConnection) {
+    char path[] = "/tmp/mymuduo_truncate_XXXXXX";
+    int fileFd = ::mkstemp(path);
+    ASSERT_GE(fileFd, 0);
+    ::unlink(path);
+    const size_t kFileSize = 64 * 1024 * 1024;
+    const size_t kTruncatedSize = 1024 * 1024;
+    ASSERT_EQ(::ftruncate(fileFd, kFileSize), 0);   // 稀疏文件，内容全为 0
+
+    TestServer server(8122);
+    std::atomic<bool> disconnected(false);
+    server.start([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            conn->sendFile(fileFd, 0, kFileSize);
+        } else {
+            disconnected = true;
+        }
+    });
+
+    int fd = connectTo(8122);
+    ASSERT_GE(fd, 0);
+    // 先不读，让服务端的发送缓冲区写满，再把文件截短到已经发出的位置之前
+    std::this_thread::sleep_for(milliseconds(100));
+    ASSERT_EQ(::ftruncate(fileFd, kTruncatedSize), 0);
+
+    // 连接一直不断开时读超时返回，而不是让测试卡住
+    struct timeval timeout = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    auto start = steady_clock::now();
+    std::string received = readUntilClose(fd);
+    double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    EXPECT_LT(received.size(), kFileSize);
+    EXPECT_LT(seconds, 4.0);
+    server.runAndWait([]() {});
+    EXPECT_TRUE(disconnected.load());
+    ::close(fd);
+    ::close(fileFd);
+}
+
+// splice 代理的半关闭：一端写完后关闭写端，另一端读到 EOF 后仍然可以回复，两个方向都结束后两个连接都断开，管道归还管道池
+TEST(TcpConnectionTest, SpliceProxyHalfClose) {
+    std::string request(8 * 1024 * 1024, 'r');
+    for (size_t i = 0; i < request.size(); i += 1000) {
+        request[i] = static_cast<char>('a' + (i / 1000) % 26);
+    }
+    const std::string reply = "REPLY";
+
+    TestServer server(8110);
+    std::unique_ptr<ProxyPairs> proxy(new ProxyPairs(&server, true));
+    int client = connectTo(8110);
+    int backend = connectTo(8110);
+    ASSERT_GE(client, 0);
+    ASSERT_GE(backend, 0);
+    proxy->waitPaired();
+
+    std::thread writer([&]() {
+        ASSERT_EQ(::write(client, request.data(), request.size()), static_cast<ssize_t>(request.size()));
+        ::shutdown(client, SHUT_WR);
+    });
+    std::string received = readUntilClose(backend);
+    writer.join();
+    EXPECT_EQ(received.size(), request.size());
+    EXPECT_TRUE(received == request);
+
+    ASSERT_EQ(::write(backend, reply.data(), reply.size()), static_cast<ssize_t>(reply.size()));
+    ::close(backend);
+    EXPECT_EQ(readUntilClose(client), reply);
+    ::close(client);
+
+    for (int i = 0; i < 100 && proxy->disconnected() < 2; ++i) {
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    EXPECT_EQ(proxy->disconnected(), 2);
+    proxy.reset();
+    size_t idlePipes = 0;
+    server.runAndWait([&]() { idlePipes = server.loop()->pipePool()->numIdle(); });
+    EXPECT_EQ(idlePipes, 2u);
+}
+
+// 后端不读时转发中的数据受管道容量限制，客户端很快被阻塞，而不是在代理的内存中无限堆积
+TEST(TcpConnectionTest, SpliceProxyBackpressure) {
+    TestServer server(8111);
+    ProxyPairs proxy(&server, true);
+    int client = connectTo(8111);
+    int backend = connectTo(8111);
+    ASSERT_GE(client, 0);
+    ASSERT_GE(backend, 0);
+    proxy.waitPaired();
+
+    // 持续写到 300ms 内都写不进去为止
+    ::fcntl(client, F_SETFL, ::fcntl(client, F_GETFL) | O_NONBLOCK);
+    const size_t kLimit = 256 * 1024 * 1024;
+    std::string chunk(64 * 1024, 'p');
+    size_t written = 0;
+    while (written < kLimit) {
+        ssize_t n = ::write(client, chunk.data(), chunk.size());
+        if (n > 0) {
+            written += n;
+            continue;
+        }
+        struct pollfd pfd = {client, POLLOUT, 0};
+        if (::poll(&pfd, 1, 300) == 0) {
+            break;
+        }
+    }
+    LOG_INFO("SpliceProxy Backpressure: client blocked after %zu bytes in flight", written);
+    EXPECT_LT(written, static_cast<size_t>(64 * 1024 * 1024));
+
+    ::shutdown(client, SHUT_WR);
+    EXPECT_EQ(readUntilClose(backend).size(), written);
+    ::close(backend);
+    ::close(client);
+}
+
+// splice 转发的数据计入后端连接的高低水位：后端暂停读取时越过高水位、暂停读取客户端，恢复读取后降到低水位，数据完整
+TEST(TcpConnectionTest, SpliceProxyHonorsWaterMarks) {
+    const size_t kTotalBytes = 32 * 1024 * 1024;
+    TestServer server(8124);
+    ProxyPairs proxy(&server, true, 64 * 1024);
+    int client = connectTo(8124);
+    int backend = connectTo(8124);
+    ASSERT_GE(client, 0);
+    ASSERT_GE(backend, 0);
+    proxy.waitPaired();
+
+    std::thread writer([&]() {
+        writeAll(client, std::string(kTotalBytes, 'h'));
+        ::shutdown(client, SHUT_WR);
+    });
+    std::this_thread::sleep_for(milliseconds(200));
+    EXPECT_GE(proxy.highs(), 1);
+    EXPECT_EQ(readUntilClose(backend).size(), kTotalBytes);
+    writer.join();
+    EXPECT_GE(proxy.lows(), 1);
+    LOG_INFO("SpliceProxy WaterMarks: %d high-water and %d low-water callbacks for %zu bytes",
+             proxy.highs(), proxy.lows(), kTotalBytes);
+    ::close(backend);
+    ::close(client);
+}
+
+// 回环上单向转发的吞吐量与每 GB 消耗的 CPU 时间（进程总 CPU，包括两端客户端）：读进用户态再发送与 splice 对比
+TEST(TcpConnectionTest, SpliceProxyBenchmark) {
+    const size_t kTotalBytes = 512 * 1024 * 1024;
+
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool splice = (mode == 1);
+        TestServer server(8112 + mode);
+        ProxyPairs proxy(&server, splice);
+        int client = connectTo(8112 + mode);
+        int backend = connectTo(8112 + mode);
+        ASSERT_GE(client, 0);
+        ASSERT_GE(backend, 0);
+        proxy.waitPaired();
+
+        struct timespec cpuStart, cpuEnd;
+        ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuStart);
+        auto start = steady_clock::now();
+        std::thread writer([&]() {
+            std::string chunk(64 * 1024, 'x');
+            size_t written = 0;
+            while (written < kTotalBytes) {
+                ssize_t n = ::write(client, chunk.data(), chunk.size());
+                if (n <= 0) {
+                    break;
+                }
+                written += n;
+            }
+        });
+        size_t received = 0;
+        char buf[65536];
+        while (received < kTotalBytes) {
+            ssize_t n = ::read(backend, buf, sizeof buf);
+            if (n <= 0) {
+                break;
+            }
+            received += n;
+        }
+        writer.join();
+        double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+        ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuEnd);
+        double cpuSeconds = (cpuEnd.tv_sec - cpuStart.tv_sec) + (cpuEnd.tv_nsec - cpuStart.tv_nsec) / 1e9;
+        EXPECT_EQ(received, kTotalBytes);
+        LOG_INFO("SpliceProxy %s: %.2f MB/s, %.3f CPU seconds per GB",
+                 splice ? "splice" : "copy", received / seconds / 1024 / 1024, cpuSeconds / (received / 1e9));
+        ::close(client);
+        ::close(backend);
+    }
+}
+
+// 后端暂停读取时，快速的上游持续写入：没有流控时数据全部堆积在代理的发送缓冲区中，
+// 开启高低水位流控后上游被暂停读取，发送缓冲区占用的内存（内存块池的峰值）保持在高水位附近
+TEST(TcpConnectionTest, WaterMarkFlowControlBoundsMemory) {
+    const size_t kTotalBytes = 128 * 1024 * 1024;
+    const size_t kHighWaterMark = 1024 * 1024;
+
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool flowControl = (mode == 1);
+        TestServer server(8114 + mode);
+        ProxyPairs proxy(&server, false, flowControl ? kHighWaterMark : 0);
+        int client = connectTo(8114 + mode);
+        int backend = connectTo(8114 + mode);
+        ASSERT_GE(client, 0);
+        ASSERT_GE(backend, 0);
+        proxy.waitPaired();
+
+        std::thread writer([&]() {
+            std::string chunk(64 * 1024, 'w');
+            size_t written = 0;
+            while (written < kTotalBytes) {
+                ssize_t n = ::write(client, chunk.data(), chunk.size());
+                if (n <= 0) {
+                    break;
+                }
+                written += n;
+            }
+        });
+        std::this_thread::sleep_for(milliseconds(300));
+        size_t received = 0;
+        char buf[65536];
+        while (received < kTotalBytes) {
+            ssize_t n = ::read(backend, buf, sizeof buf);
+            if (n <= 0) {
+                break;
+            }
+            received += n;
+        }
+        writer.join();
+        EXPECT_EQ(received, kTotalBytes);
+
+        size_t peak = 0;
+        server.runAndWait([&]() { peak = server.loop()->bufferPool()->peakBytesInUse(); });
+        LOG_INFO("WaterMark flow control %s: peak output buffer memory %zu bytes for %zu bytes forwarded",
+                 flowControl ? "on" : "off", peak, kTotalBytes);
+        if (flowControl) {
+            EXPECT_LT(peak, 4 * kHighWaterMark);
+        }
+        ::close(client);
+        ::close(backend);
+    }
+}
+
+// 排队中的文件和零拷贝数据同样计入高低水位：对端不读时越过高水位，全部发送完毕后才回调低水位
+TEST(TcpConnectionTest, WaterMarksCountQueuedEntries) {
+    char path[] = "/tmp/mymuduo_watermark_XXXXXX";
+    int fileFd = ::mkstemp(path);
+    ASSERT_GE(fileFd, 0);
+    ::unlink(path);
+    const size_t kFileSize = 16 * 1024 * 1024;
+    const size_t kPayloadSize = 4 * 1024 * 1024;
+    const size_t kHighWaterMark = 1024 * 1024;
+    ASSERT_EQ(::ftruncate(fileFd, kFileSize), 0);
+
+    TestServer server(8123);
+    std::atomic<int> highs(0);
+    std::atomic<int> lows(0);
+    std::atomic<size_t> highBytes(0);
+    std::atomic<size_t> lowBytes(1);
+    server.start([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            conn->setHighWaterMarkCallback([&](const TcpConnectionPtr&, size_t bytes) {
+                ++highs;
+                highBytes = bytes;
+            }, kHighWaterMark);
+            conn->setLowWaterMarkCallback([&](const TcpConnectionPtr&, size_t bytes) {
+                ++lows;
+                lowBytes = bytes;
+            }, 0);
+            conn->setZeroCopyThreshold(64 * 1024);
+            conn->sendFile(fileFd, 0, kFileSize);
+            conn->send(std::string(kPayloadSize, 'z'));
+            conn->shutdown();
+        }
+    });
+
+    int fd = connectTo(8123);
+    ASSERT_GE(fd, 0);
+    std::this_thread::sleep_for(milliseconds(100));
+    EXPECT_EQ(highs.load(), 1);
+    EXPECT_EQ(lows.load(), 0);
+    EXPECT_GE(highBytes.load(), kHighWaterMark);
+
+    std::string received = readUntilClose(fd);
+    EXPECT_EQ(received.size(), kFileSize + kPayloadSize);
+    server.runAndWait([]() {});
+    EXPECT_EQ(highs.load(), 1);
+    EXPECT_EQ(lows.load(), 1);
+    EXPECT_EQ(lowBytes.load(), 0u);
+    ::close(fd);
+    ::close(fileFd);
+}
+
+// 没有设置空闲回调时，持续有数据到达的连接保持连接，停止发送之后大约一个读空闲超时被断开
+TEST(TcpConnectionTest, IdleTimeoutClosesInactiveConnection) {
+    const double kReaderIdle = 0.2;
+    TestServer server(8120);
+    server.start([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            conn->setIdleTimeout(kReaderIdle, 0.0, 0.0);
+        }
+    });
+
+    int fd = connectTo(8120);
+    ASSERT_GE(fd, 0);
+    // 活跃时间是读空闲超时的两倍多，连接不应该被断开
+    auto lastPing = steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+        std::this_thread::sleep_for(milliseconds(50));
+        ASSERT_EQ(::write(fd, "p", 1), 1);
+        lastPing = steady_clock::now();
+    }
+    struct pollfd pfd = {fd, POLLIN, 0};
+    EXPECT_EQ(::poll(&pfd, 1, 0), 0);
+
+    EXPECT_EQ(readUntilClose(fd), "");
+    double idleSeconds = duration_cast<duration<double>>(steady_clock::now() - lastPing).count();
+    LOG_INFO("IdleTimeout: connection closed %.3f seconds after the last message (reader idle %.1f s)",
+             idleSeconds, kReaderIdle);
+    EXPECT_GE(idleSeconds, kReaderIdle - 0.01);
+    EXPECT_LT(idleSeconds, kReaderIdle + 0.3);
+    ::close(fd);
+}
+
+// 只读不写的连接报告写空闲，读到数据期间不报告读空闲，停止发送之后才报告
+TEST(TcpConnectionTest, IdleCallbackReportsIdleType) {
+    const double kIdle = 0.1;
+    TestServer server(8121);
+    std::vector<std::pair<IdleType, steady_clock::time_point>> events;
+    server.start([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            conn->setIdleCallback([&](const TcpConnectionPtr&, IdleType type) {
+                events.emplace_back(type, steady_clock::now());
+            });
+            conn->setIdleTimeout(kIdle, kIdle, 0.0);
+        }
+    });
+
+    int fd = connectTo(8121);
+    ASSERT_GE(fd, 0);
+    for (int i = 0; i < 18; ++i) {
+        ASSERT_EQ(::write(fd, "p", 1), 1);
+        std::this_thread::sleep_for(milliseconds(20));
+    }
+    auto stopped = steady_clock::now();
+    std::this_thread::sleep_for(milliseconds(250));
+
+    int readerIdleWhileActive = 0;
+    int writerIdleWhileActive = 0;
+    int readerIdleAfterStop = 0;
+    server.runAndWait([&]() {
+        for (const auto& event : events) {
+            bool active = event.second < stopped;
+            if (event.first == kReaderIdle) {
+                (active ? readerIdleWhileActive : readerIdleAfterStop)++;
+            } else if (event.first == kWriterIdle && active) {
+                ++writerIdleWhileActive;
+            }
+        }
+    });
+    LOG_INFO("IdleCallback: %d writer idle while active, %d reader idle while active, %d reader idle after stop",
+             writerIdleWhileActive, readerIdleWhileActive, readerIdleAfterStop);
+    EXPECT_EQ(readerIdleWhileActive, 0);
+    EXPECT_GE(writerIdleWhileActive, 2);
+    EXPECT_GE(readerIdleAfterStop, 1);
+    ::close(fd);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "CountDownLatch.h"
+#include "InetAddress.h"
+
+// 各个网络测试共用的客户端辅助函数和单线程测试服务器
+namespace muduo {
+namespace test {
+
+// 阻塞地连接本机的 port，失败返回 -1
+inline int connectTo(int port, bool noDelay = false) {
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        ::close(sockfd);
+        return -1;
+    }
+    if (noDelay) {
+        int on = 1;
+        ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return sockfd;
+}
+
+// 读满 len 字节，连接关闭或出错时返回 false
+inline bool readFully(int fd, char* buf, size_t len) {
+    size_t received = 0;
+    while (received < len) {
+        ssize_t n = ::read(fd, buf + received, len - received);
+        if (n <= 0) {
+            return false;
+        }
+        received += n;
+    }
+    return true;
+}
+
+inline bool writeAll(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n <= 0) {
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+// 读到对端关闭为止
+inline std::string readUntilClose(int fd) {
+    std::string result;
+    char buf[65536];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+        result.append(buf, n);
+    }
+    return result;
+}
+
+// 端口能否立即重新绑定
+inline bool canBind(int port) {
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    ::setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    bool ok = ::bind(sockfd, (sockaddr*)&addr, sizeof(addr)) == 0;
+    ::close(sockfd);
+    return ok;
+}
+
+// 在 loop 所在的 IO 线程中执行 cb 并等待其完成
+inline void runInLoopAndWait(EventLoop* loop, const std::function<void()>& cb) {
+    CountDownLatch latch(1);
+    loop->runInLoop([&]() {
+        cb();
+        latch.countDown();
+    });
+    latch.wait();
+}
+
+// 单个 IO 线程的 TcpServer，在 IO 线程中创建和销毁，保证 isInLoopThread 的判断与实际运行的线程一致
+class TestServer {
+public:
+    explicit TestServer(int port, const std::string& name = "TestServer")
+        : loop_(loopThread_.startLoop()), port_(port), name_(name) {}
+
+    ~TestServer() {
+        runAndWait([this]() { server_.reset(); });
+    }
+
+    void start(const ConnectionCallback& connCb, const MessageCallback& msgCb = MessageCallback()) {
+        runAndWait([this, connCb, msgCb]() {
+            server_.reset(new TcpServer(loop_, InetAddress(port_), name_));
+            server_->setConnectionCallback(connCb);
+            server_->setMessageCallback(msgCb ? msgCb : [](const TcpConnectionPtr&, Buffer* buf, TimeStamp) {
+                buf->retrieveAll();
+            });
+            server_->start();
+        });
+    }
+
+    EventLoop* loop() const { return loop_; }
+
+    void runAndWait(const std::function<void()>& cb) { runInLoopAndWait(loop_, cb); }
+
+private:
+    EventLoopThread loopThread_;
+    EventLoop* loop_;
+    int port_;
+    std::string name_;
+    std::unique_ptr<TcpServer> server_;
+};
+
+}
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "TimerPool.h"
+#include "Timer.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "CountDownLatch.h"
+#include "Logger.h"
+
+using namespace muduo;
+using namespace std::chrono;
+
+// 释放的 Timer 放回空闲链表并被下一次 create 复用，回调持有的对象在 destroy 时释放
+TEST(TimerPoolTest, ReusesSlots) {
+    TimerPool pool;
+    std::shared_ptr<int> token = std::make_shared<int>(0);
+    Timer* first = pool.create([token]() {}, MonoTime::now(), 0.0, Timer::newSequence());
+    EXPECT_EQ(token.use_count(), 2);
+    pool.destroy(first);
+    EXPECT_EQ(token.use_count(), 1);
+    Timer* second = pool.create(TimerCallback(), MonoTime::now(), 0.0, Timer::newSequence());
+    EXPECT_EQ(first, second);
+    pool.destroy(second);
+
+    // 同时存在的定时器不超过一块时只申请一块内存
+    std::vector<Timer*> live;
+    for (int i = 0; i < 100000; ++i) {
+        live.push_back(pool.create(TimerCallback(), MonoTime::now(), 0.0, Timer::newSequence()));
+        if (live.size() == TimerPool::kTimersPerChunk) {
+            for (Timer* timer : live) {
+                pool.destroy(timer);
+            }
+            live.clear();
+        }
+    }
+    for (Timer* timer : live) {
+        pool.destroy(timer);
+    }
+    EXPECT_EQ(pool.numChunks(), 1u);
+    EXPECT_EQ(pool.numInUse(), 0u);
+}
+
+// 每个请求设置一个超时定时器、请求完成后取消：对象池与全局分配器对比，以及经由 EventLoop 的添加/取消速度
+TEST(TimerPoolTest, Benchmark) {
+    const int kRequests = 1000 * 1000;
+    const size_t kInflight = 64;
+    std::vector<Timer*> inflight(kInflight, nullptr);
+
+    auto t0 = steady_clock::now();
+    for (int i = 0; i < kRequests; ++i) {
+        Timer*& slot = inflight[i % kInflight];
+        delete slot;
+        slot = new Timer(TimerCallback(), MonoTime(i), 0.0);
+    }
+    for (Timer*& timer : inflight) {
+        delete timer;
+        timer = nullptr;
+    }
+    auto t1 = steady_clock::now();
+
+    TimerPool pool;
+    for (int i = 0; i < kRequests; ++i) {
+        Timer*& slot = inflight[i % kInflight];
+        if (slot != nullptr) {
+            pool.destroy(slot);
+        }
+        slot = pool.create(TimerCallback(), MonoTime(i), 0.0, Timer::newSequence());
+    }
+    for (Timer* timer : inflight) {
+        pool.destroy(timer);
+    }
+    auto t2 = steady_clock::now();
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    double loopSeconds = 0;
+    CountDownLatch done(1);
+    loop->runInLoop([&]() {
+        std::vector<TimerId> ids(kInflight);
+        auto start = steady_clock::now();
+        for (int i = 0; i < kRequests; ++i) {
+            TimerId& id = ids[i % kInflight];
+            loop->cancel(id);
+            id = loop->runAfter(5.0, []() {});
+        }
+        for (TimerId id : ids) {
+            loop->cancel(id);
+        }
+        loopSeconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+        done.countDown();
+    });
+    done.wait();
+
+    auto rate = [](double seconds) { return kRequests / seconds / 1e6; };
+    double newSeconds = duration_cast<duration<double>>(t1 - t0).count();
+    double poolSeconds = duration_cast<duration<double>>(t2 - t1).count();
+    LOG_INFO("TimerPool Benchmark: new/delete %.1f M/s, pool %.1f M/s, EventLoop runAfter+cancel %.2f M/s",
+             rate(newSeconds), rate(poolSeconds), rate(loopSeconds));
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include <sys/prctl.h>
+
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "CountDownLatch.h"
+#include "MonoTime.h"
+#include "Logger.h"
+
+using namespace muduo;
+
+namespace {
+
+struct Jitter {
+    int64_t p50Ns;
+    int64_t p99Ns;
+    int64_t maxNs;
+    int early;
+    uint64_t timerSyscalls;     // poll 加上 timerfd_settime，timerfd 到期时还要再读一次 timerfd
+};
+
+// 节拍定时器：每次在上一次的到期时间上加 periodNs 再定时，记录每次实际触发时间与到期时间之差
+Jitter measurePacing(bool useIoUring, bool preciseWait, double resolution, int64_t periodNs, int ticks) {
+    if (useIoUring) {
+        ::setenv("MUDUO_USE_IO_URING", "1", 1);
+    }
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    ::unsetenv("MUDUO_USE_IO_URING");
+
+    std::vector<int64_t> lateness;
+    lateness.reserve(ticks);
+    CountDownLatch done(1);
+    uint64_t syscallsBefore = 0;
+    uint64_t rearmsBefore = 0;
+    std::function<void(MonoTime)> schedule;
+    schedule = [&](MonoTime when) {
+        loop->runAt(when, [&, when]() {
+            lateness.push_back(MonoTime::now().nanoSeconds() - when.nanoSeconds());
+            if (static_cast<int>(lateness.size()) == ticks) {
+                done.countDown();
+            } else {
+                schedule(MonoTime(when.nanoSeconds() + periodNs));
+            }
+        });
+    };
+    loop->runInLoop([&]() {
+        loop->setPreciseTimerWait(preciseWait);
+        loop->setTimerResolution(resolution);
+        syscallsBefore = loop->numPollerSyscalls();
+        rearmsBefore = loop->numTimerRearmsIssued();
+        schedule(MonoTime(MonoTime::now().nanoSeconds() + periodNs));
+    });
+    done.wait();
+
+    Jitter result;
+    result.timerSyscalls = loop->numPollerSyscalls() - syscallsBefore + loop->numTimerRearmsIssued() - rearmsBefore;
+    result.early = static_cast<int>(std::count_if(lateness.begin(), lateness.end(), [](int64_t l) { return l < 0; }));
+    std::sort(lateness.begin(), lateness.end());
+    result.p50Ns = lateness[lateness.size() / 2];
+    result.p99Ns = lateness[lateness.size() * 99 / 100];
+    result.maxNs = lateness.back();
+    return result;
+}
+
+}
+
+TEST(TimerPrecisionTest, PacingJitter) {
+    const int kTicks = 2000;
+    struct Mode {
+        const char* name;
+        bool ioUring;
+        bool precise;
+        double resolution;
+    } modes[] = {
+        {"timerfd, 1us resolution", false, false, 0.000001},
+        {"epoll_pwait2, 1us resolution", false, true, 0.000001},
+        {"io_uring, 1us resolution", true, true, 0.000001},
+    };
+    for (int64_t periodUs : {20, 50}) {
+        for (const Mode& mode : modes) {
+            Jitter j = measurePacing(mode.ioUring, mode.precise, mode.resolution, periodUs * 1000, kTicks);
+            LOG_INFO("TimerPrecision %ldus pacing, %s: lateness p50 %.1f us, p99 %.1f us, max %.1f us, %d early, %.2f poll/timerfd_settime calls per tick",
+                     periodUs, mode.name, j.p50Ns / 1e3, j.p99Ns / 1e3, j.maxNs / 1e3, j.early,
+                     static_cast<double>(j.timerSyscalls) / kTicks);
+            EXPECT_EQ(j.early, 0);
+        }
+    }
+}
+
+// 精确等待默认关闭，不改动 IO 线程的 timer slack；开启时设为 1ns，关闭后恢复原来的值
+TEST(TimerPrecisionTest, TimerSlackRestored) {
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    long initial = -1;
+    long enabled = -1;
+    long restored = -1;
+    CountDownLatch done(1);
+    loop->runInLoop([&]() {
+        ::prctl(PR_SET_TIMERSLACK, 200000UL);
+        initial = ::prctl(PR_GET_TIMERSLACK);
+        loop->setPreciseTimerWait(true);
+        enabled = ::prctl(PR_GET_TIMERSLACK);
+        loop->setPreciseTimerWait(false);
+        restored = ::prctl(PR_GET_TIMERSLACK);
+        done.countDown();
+    });
+    done.wait();
+    EXPECT_EQ(initial, 200000);
+    EXPECT_EQ(enabled, 1);
+    EXPECT_EQ(restored, 200000);
+}
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include "TimerWheel.h"
+#include "Timer.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "CountDownLatch.h"
+#include "Logger.h"
+
+using namespace muduo;
+using namespace std::chrono;
+
+namespace {
+
+// 原来 TimerQueue 中的实现：按到期时间排序的 set，加上按 (Timer*, 序号) 查找的 set
+class SetTimerList {
+public:
+    explicit SetTimerList(MonoTime) {}
+
+    void insert(Timer* timer) {
+        timers_.insert(Entry(timer->expiration(), timer));
+        activeTimers_.insert(ActiveTimer(timer, timer->sequence()));
+    }
+
+    bool cancel(Timer* timer, int64_t sequence) {
+        auto it = activeTimers_.find(ActiveTimer(timer, sequence));
+        if (it == activeTimers_.end()) {
+            return false;
+        }
+        timers_.erase(Entry(it->first->expiration(), it->first));
+        activeTimers_.erase(it);
+        return true;
+    }
+
+    void getExpired(MonoTime now, std::vector<Timer*>* expired) {
+        auto end = timers_.lower_bound(Entry(now, reinterpret_cast<Timer*>(UINTPTR_MAX)));
+        for (auto it = timers_.begin(); it != end; ++it) {
+            expired->push_back(it->second);
+            activeTimers_.erase(ActiveTimer(it->second, it->second->sequence()));
+        }
+        timers_.erase(timers_.begin(), end);
+    }
+
+private:
+    using Entry = std::pair<MonoTime, Timer*>;
+    using ActiveTimer = std::pair<Timer*, int64_t>;
+
+    std::set<Entry> timers_;
+    std::set<ActiveTimer> activeTimers_;
+};
+
+// 与 TimerQueue 相同：时间轮加上按序号查找的哈希表
+class WheelTimerList {
+public:
+    explicit WheelTimerList(MonoTime now) : wheel_(1000 * 1000, now) {}
+
+    void insert(Timer* timer) {
+        wheel_.insert(timer);
+        activeTimers_.insert(std::make_pair(timer->sequence(), timer));
+    }
+
+    // 与 SetTimerList::cancel 的参数保持一致，时间轮只按 sequence 查找
+    bool cancel(Timer*, int64_t sequence) {
+        auto it = activeTimers_.find(sequence);
+        if (it == activeTimers_.end()) {
+            return false;
+        }
+        wheel_.remove(it->second);
+        activeTimers_.erase(it);
+        return true;
+    }
+
+    void getExpired(MonoTime now, std::vector<Timer*>* expired) {
+        size_t first = expired->size();
+        wheel_.advance(now, expired);
+        for (size_t i = first; i < expired->size(); ++i) {
+            activeTimers_.erase((*expired)[i]->sequence());
+        }
+    }
+
+private:
+    TimerWheel wheel_;
+    std::unordered_map<int64_t, Timer*> activeTimers_;
+};
+
+// 添加 n 个 60 秒内随机到期的定时器，取消一半，再按 1ms 的步长推进直到全部到期，返回三个阶段各自的每秒操作数
+template <typename List>
+void runTimerBenchmark(const char* name, int n) {
+    const int64_t kMs = 1000 * 1000;
+    const int64_t base = MonoTime::now().nanoSeconds();
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int64_t> delay(1, 60 * 1000 * kMs);
+    std::vector<MonoTime> whens(n);
+    for (MonoTime& when : whens) {
+        when = MonoTime(base + delay(rng));
+    }
+
+    std::unique_ptr<List> list(new List(MonoTime(base)));
+    std::vector<Timer*> timers(n);
+    auto t0 = steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        timers[i] = new Timer(TimerCallback(), whens[i], 0.0);
+        list->insert(timers[i]);
+    }
+    auto t1 = steady_clock::now();
+    for (int i = 0; i < n; i += 2) {
+        EXPECT_TRUE(list->cancel(timers[i], timers[i]->sequence()));
+        delete timers[i];
+    }
+    auto t2 = steady_clock::now();
+    std::vector<Timer*> expired;
+    size_t numExpired = 0;
+    for (int64_t now = base; now <= base + 60 * 1000 * kMs + kMs; now += kMs) {
+        expired.clear();
+        list->getExpired(MonoTime(now), &expired);
+        for (Timer* timer : expired) {
+            delete timer;
+        }
+        numExpired += expired.size();
+    }
+    auto t3 = steady_clock::now();
+    EXPECT_EQ(numExpired, static_cast<size_t>(n / 2));
+
+    auto rate = [](int count, steady_clock::duration d) {
+        return count / duration_cast<duration<double>>(d).count();
+    };
+    LOG_INFO("TimerWheel Benchmark %s: %d timers, add %.2f M/s, cancel %.2f M/s, expire %.2f M/s (60000 1ms steps)",
+             name, n, rate(n, t1 - t0) / 1e6, rate(n / 2, t2 - t1) / 1e6, rate(n / 2, t3 - t2) / 1e6);
+}
+
+}
+
+// 与按时间排序的参考实现对比：每个定时器都在第一次推进到其到期时间之后的那一步到期，不提前也不遗漏
+static void checkAgainstReference(int64_t kTickNs, const std::vector<int64_t>& ranges) {
+    const int64_t kUs = 1000;
+    const int64_t base = MonoTime::now().nanoSeconds();
+    std::mt19937_64 rng(7);
+    TimerWheel wheel(kTickNs, MonoTime(base));
+
+    std::vector<std::unique_ptr<Timer>> timers;
+    std::set<Timer*> pending;
+    for (int i = 0; i < 20000; ++i) {
+        std::uniform_int_distribution<int64_t> delay(-kTickNs, ranges[i % ranges.size()]);
+        timers.emplace_back(new Timer(TimerCallback(), MonoTime(base + delay(rng)), 0.0));
+        wheel.insert(timers.back().get());
+        pending.insert(timers.back().get());
+    }
+    for (size_t i = 0; i < timers.size(); i += 7) {
+        wheel.remove(timers[i].get());
+        pending.erase(timers[i].get());
+    }
+    EXPECT_EQ(wheel.size(), pending.size());
+
+    // 步长从一个 tick 到几个小时不等
+    int64_t now = base;
+    int64_t prevTick = base / kTickNs;
+    std::vector<Timer*> expired;
+    bool inOrder = true;
+    while (!pending.empty()) {
+        MonoTime next = wheel.nextExpiration();
+        int64_t earliest = INT64_MAX;
+        for (Timer* timer : pending) {
+            earliest = std::min(earliest, timer->expiration().nanoSeconds());
+        }
+        // 下一次处理时间不晚于最早的到期时间所在的 tick
+        EXPECT_LE(next.nanoSeconds(), std::max((earliest + kTickNs - 1) / kTickNs, prevTick + 1) * kTickNs);
+
+        std::uniform_int_distribution<int> kind(0, 3);
+        int k = kind(rng);
+        now += k == 0 ? kTickNs : k == 1 ? 37 * kTickNs : k == 2 ? 5 * 1000 * 1000 * kUs : 3 * 3600 * 1000 * 1000LL * kUs;
+        expired.clear();
+        wheel.advance(MonoTime(now), &expired);
+        int64_t nowTick = now / kTickNs;
+        for (Timer* timer : expired) {
+            int64_t tick = (timer->expiration().nanoSeconds() + kTickNs - 1) / kTickNs;
+            if (pending.erase(timer) != 1 || tick > nowTick || (tick > base / kTickNs && tick <= prevTick)) {
+                inOrder = false;
+            }
+        }
+        for (Timer* timer : pending) {
+            int64_t tick = (timer->expiration().nanoSeconds() + kTickNs - 1) / kTickNs;
+            if (tick <= nowTick) {
+                inOrder = false;
+            }
+        }
+        prevTick = nowTick;
+        ASSERT_TRUE(inOrder);
+    }
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_FALSE(wheel.nextExpiration().valid());
+}
+
+TEST(TimerWheelTest, MatchesReference) {
+    const int64_t kUs = 1000;
+    // 1ms 精度下覆盖各层，最高层可以覆盖数年
+    checkAgainstReference(1000 * kUs, {200 * 1000LL * kUs, 10 * 1000 * 1000LL * kUs, 600 * 1000 * 1000LL * kUs,
+                                       3600 * 1000 * 1000LL * 24 * kUs, 3600 * 1000 * 1000LL * 48 * kUs});
+}
+
+// 1us 精度：秒级到分钟级的超时在上层等待，也覆盖超出最高层范围（约 76 小时）的到期时间
+// 推进时直接跳到下一个非空槽，几个小时的空闲跨度不会逐个经过下移边界
+TEST(TimerWheelTest, MicrosecondTick) {
+    const int64_t kUs = 1000;
+    checkAgainstReference(kUs, {1000 * 1000LL * kUs, 30 * 1000 * 1000LL * kUs, 600 * 1000 * 1000LL * kUs,
+                                3600 * 1000 * 1000LL * 100 * kUs});
+}
+
+// 通过 EventLoop 使用：不提前触发，最多晚一个精度（加上调度的余量）；调整精度后已有的定时器照常触发
+TEST(TimerWheelTest, EventLoopTimers) {
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    const int kTimers = 50;
+    CountDownLatch fired(kTimers + 1);
+    std::atomic<int64_t> maxLateUs(0);
+    std::atomic<int> early(0);
+    for (int i = 0; i < kTimers; ++i) {
+        double delay = 0.001 * (i % 10) + 0.0003 * i;
+        TimeStamp when = addTime(TimeStamp::now(), delay);
+        loop->runAt(when, [&, when]() {
+            int64_t late = TimeStamp::now().microSecondsSinceEpoch() - when.microSecondsSinceEpoch();
+            if (late < 0) {
+                ++early;
+            }
+            int64_t prev = maxLateUs.load();
+            while (late > prev && !maxLateUs.compare_exchange_weak(prev, late)) {
+            }
+            fired.countDown();
+        });
+    }
+    // 改为 100us 精度之后，已有的定时器仍然触发
+    loop->runAfter(0.2, [&]() { fired.countDown(); });
+    loop->setTimerResolution(0.0001);
+
+    std::atomic<int> ticks(0);
+    loop->runEvery(0.01, [&]() { ++ticks; });
+    fired.wait();
+    std::this_thread::sleep_for(milliseconds(100));
+    LOG_INFO("TimerWheel EventLoopTimers: max lateness %ld us, %d runEvery(10ms) ticks in about 300ms",
+             maxLateUs.load(), ticks.load());
+    EXPECT_EQ(early.load(), 0);
+    EXPECT_LT(maxLateUs.load(), 20000);
+    EXPECT_GE(ticks.load(), 20);
+}
+
+// 100 万个定时器：时间轮与原来基于 set 的实现对比
+TEST(TimerWheelTest, Benchmark) {
+    const int kTimers = 1000 * 1000;
+    runTimerBenchmark<SetTimerList>("std::set", kTimers);
+    runTimerBenchmark<WheelTimerList>("wheel", kTimers);
+}